@@ -0,0 +1,37 @@
+#include "allocation_counter.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local bench::AllocationCount t_allocations;
+}
+
+namespace bench
+{
+    AllocationCount thread_allocations()
+    {
+        return t_allocations;
+    }
+}
+
+void *operator new(size_t size)
+{
+    ++t_allocations.allocations;
+    t_allocations.bytes += size;
+    if (void *memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
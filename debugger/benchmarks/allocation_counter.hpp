@@ -0,0 +1,45 @@
+#pragma once
+// Heap allocations made by the calling thread, counted by replacing the global
+// operator new in the executables that link allocation_counter.cpp. Counting
+// per thread keeps background threads (async sinks, capture writers) out of
+// the numbers: what is left is the cost on the thread being measured.
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace bench
+{
+    struct AllocationCount
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Totals for the calling thread since it started
+    AllocationCount thread_allocations();
+
+    // Counts what the benchmark loop between construction and report() allocates
+    class AllocationMeter
+    {
+    public:
+        AllocationMeter() : m_start(thread_allocations()) {}
+
+        AllocationCount elapsed() const
+        {
+            AllocationCount now = thread_allocations();
+            return {now.allocations - m_start.allocations, now.bytes - m_start.bytes};
+        }
+
+        // Sets allocs/op and bytes/op, an op being ops_per_iteration of one iteration
+        void report(benchmark::State &state, double ops_per_iteration = 1.0) const
+        {
+            AllocationCount count = elapsed();
+            double ops = static_cast<double>(state.iterations()) * ops_per_iteration;
+            state.counters["allocs/op"] = ops ? static_cast<double>(count.allocations) / ops : 0.0;
+            state.counters["bytes/op"] = ops ? static_cast<double>(count.bytes) / ops : 0.0;
+        }
+
+    private:
+        AllocationCount m_start;
+    };
+}
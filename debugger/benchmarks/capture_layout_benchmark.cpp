@@ -0,0 +1,106 @@
+// Directory resolution for the per-file capture layout, with and without the
+// path cache, over a mix of request endpoints and full response URLs similar
+// to a play session: a few hot endpoints and a long tail.
+//
+// Directories are created under the temp directory.
+
+#include <benchmark/benchmark.h>
+#include <logging/capture_layout.hpp>
+#include <random>
+
+using namespace core::logging;
+
+namespace
+{
+    struct Capture
+    {
+        std::string host;
+        std::string endpoint;
+        bool isFullUrl;
+    };
+
+    std::vector<Capture> makeEndpointMix(size_t count)
+    {
+        const std::string host = "https://wbnet-api.example.com";
+        const std::vector<std::string> hot = {
+            "/ssc/invoke/get_server_time",
+            "/ssc/invoke/heartbeat",
+            "/profiles/me",
+            "/ssc/invoke/get_inventory",
+        };
+
+        std::vector<std::string> tail;
+        for (int i = 0; i < 60; ++i)
+        {
+            tail.push_back(std::format("/ssc/invoke/nemesis_{}/details", i));
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            tail.push_back(std::format("/matches/{}/results?page={}", 1000 + i, i % 3));
+        }
+
+        // 80% of traffic goes to the hot endpoints; half the captures are responses
+        std::mt19937 random(42);
+        std::vector<Capture> mix;
+        mix.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::string &endpoint = random() % 5 != 0 ? hot[random() % hot.size()] : tail[random() % tail.size()];
+            if (i % 2 == 0)
+            {
+                mix.push_back({host, endpoint, false});
+            }
+            else
+            {
+                mix.push_back({"", host + endpoint, true});
+            }
+        }
+        return mix;
+    }
+
+    void resolveMix(benchmark::State &state, size_t cacheCapacity)
+    {
+        static const std::vector<Capture> mix = makeEndpointMix(4096);
+
+        CaptureLayout layout((std::filesystem::temp_directory_path() / "capture_layout_benchmark").string());
+        layout.set_path_cache_capacity(cacheCapacity);
+
+        size_t next = 0;
+        for (auto _ : state)
+        {
+            const Capture &capture = mix[next];
+            benchmark::DoNotOptimize(layout.resolve_directory(capture.host, capture.endpoint, capture.isFullUrl).data());
+            next = (next + 1) % mix.size();
+        }
+
+        const auto &stats = layout.path_cache_stats();
+        state.counters["hits"] = static_cast<double>(stats.hits);
+        state.counters["misses"] = static_cast<double>(stats.misses);
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+static void BM_ResolveUncached(benchmark::State &state)
+{
+    resolveMix(state, 0);
+}
+BENCHMARK(BM_ResolveUncached);
+
+static void BM_ResolveCached(benchmark::State &state)
+{
+    resolveMix(state, static_cast<size_t>(state.range(0)));
+}
+// Smaller than the working set, then large enough for all of it
+BENCHMARK(BM_ResolveCached)->Arg(32)->Arg(1024);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    // Resolution only logs on failure
+    Logger::setMinLevel(LogLevel::Warning);
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,337 @@
+// The debugger's hot paths over synthetic trees of a chosen shape and size:
+// map iteration and lookup, list and tree rendering, print_value, capture
+// (RequestFileLogger::save_response) and Logger::log.
+//
+// Each run reports time per op, allocs/op and bytes/op (allocations made on
+// the benchmark thread; see allocation_counter.hpp) and the shape it ran on
+// as its label. Shapes and sizes are benchmark arguments, so a run can be
+// narrowed with --benchmark_filter, e.g. 'BM_PrintValue/shape:0/size:4096'
+// for a wide map of 4096 entries.
+//
+// To compare two commits, write JSON from each and diff them with Google
+// Benchmark's tools/compare.py:
+//
+//   hydra-benchmark --benchmark_out=before.json --benchmark_out_format=json
+//   compare.py benchmarks before.json after.json
+//
+// (the benchmark-json target writes hydra-benchmark.json to the build tree).
+
+#include <benchmark/benchmark.h>
+#include <hydra/value_visitor.hpp>
+#include <logging/logger.hpp>
+#include <logging/request_logger.hpp>
+#include <logging/sinks.hpp>
+#include <synthetic/builder.hpp>
+#include "allocation_counter.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <random>
+
+using namespace hydra;
+
+namespace
+{
+    enum Shape : int64_t
+    {
+        Wide,       // One map of size scalar entries
+        Deep,       // size maps nested one inside the other
+        LongList,   // A list of size scalars
+        LongString, // A small map holding one string of size bytes
+    };
+
+    const char *shape_name(int64_t shape)
+    {
+        switch (shape)
+        {
+        case Wide:
+            return "wide";
+        case Deep:
+            return "deep";
+        case LongList:
+            return "long_list";
+        case LongString:
+            return "long_string";
+        }
+        return "unknown";
+    }
+
+    std::string key_name(size_t index)
+    {
+        return std::format("key_{:05}", index);
+    }
+
+    Value *build(synthetic::Builder &builder, int64_t shape, size_t size)
+    {
+        switch (shape)
+        {
+        case Wide:
+        {
+            std::vector<std::pair<std::string, Value *>> entries;
+            for (size_t i = 0; i < size; ++i)
+            {
+                Value *value = i % 2 ? builder.string(std::format("value_{}", i)) : builder.integer(static_cast<int64_t>(i));
+                entries.emplace_back(key_name(i), value);
+            }
+            return builder.map(std::move(entries));
+        }
+        case Deep:
+        {
+            Value *node = builder.string("leaf");
+            for (size_t i = 0; i < size; ++i)
+            {
+                node = builder.map({{"level", builder.integer(static_cast<int64_t>(i))}, {"child", node}});
+            }
+            return node;
+        }
+        case LongList:
+        {
+            std::vector<Value *> items;
+            for (size_t i = 0; i < size; ++i)
+            {
+                items.push_back(i % 2 ? builder.string(std::format("item_{}", i)) : builder.integer(static_cast<int64_t>(i)));
+            }
+            return builder.list(std::move(items));
+        }
+        case LongString:
+            return builder.map({{"id", builder.integer(1)}, {"blob", builder.string(std::string(size, 'x'))}});
+        }
+        return nullptr;
+    }
+
+    // Built once per shape and size for the whole run
+    const synthetic::Tree &tree(int64_t shape, size_t size)
+    {
+        static synthetic::Builder builder;
+        static std::map<std::pair<int64_t, size_t>, synthetic::Tree> trees;
+
+        auto [it, inserted] = trees.try_emplace({shape, size});
+        if (inserted)
+        {
+            size_t before = builder.nodes();
+            it->second.root = build(builder, shape, size);
+            it->second.nodes = builder.nodes() - before;
+        }
+        return it->second;
+    }
+
+    const synthetic::Tree &tree(benchmark::State &state)
+    {
+        state.SetLabel(shape_name(state.range(0)));
+        return tree(state.range(0), static_cast<size_t>(state.range(1)));
+    }
+
+    // Keeps log output out of the measurement; only the logger's own work remains
+    class NullSink : public core::logging::Sink
+    {
+    public:
+        NullSink() : Sink(core::logging::LogLevel::Trace) {}
+
+        void append(core::logging::LogLevel, std::string_view line) override
+        {
+            benchmark::DoNotOptimize(line.data());
+        }
+
+        void flush() override {}
+    };
+
+    std::filesystem::path scratch_directory(std::string_view name)
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "hydra-benchmark" / name;
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        return path;
+    }
+
+    // Deep trees stay shallower: their text layout grows with the square of the depth
+    void all_shapes(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"shape", "size"});
+        benchmark->ArgsProduct({{Wide, LongList, LongString}, {16, 4096}});
+        benchmark->ArgsProduct({{Deep}, {16, 256}});
+    }
+
+    void only(benchmark::internal::Benchmark *benchmark, Shape shape)
+    {
+        benchmark->ArgNames({"shape", "size"});
+        benchmark->ArgsProduct({{shape}, {16, 256, 4096}});
+    }
+}
+
+// One op: advancing MapIterator by one entry and reading it
+static void BM_MapIterator(benchmark::State &state)
+{
+    IterableMap *map = static_cast<IterableMap *>(tree(state).root);
+    size_t entries = static_cast<size_t>(state.range(1));
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        for (auto it = map->begin(); it != map->end(); ++it)
+        {
+            benchmark::DoNotOptimize(it.key().data());
+        }
+    }
+    meter.report(state, static_cast<double>(entries));
+    state.SetItemsProcessed(state.iterations() * entries);
+}
+BENCHMARK(BM_MapIterator)->Apply([](auto *b) { only(b, Wide); });
+
+// One op: one MapValue::get_value_by_key, keys taken in random order
+static void BM_GetValueByKey(benchmark::State &state)
+{
+    MapValue *map = static_cast<MapValue *>(tree(state).root);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < static_cast<size_t>(state.range(1)); ++i)
+    {
+        keys.push_back(key_name(i));
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        for (const std::string &key : keys)
+        {
+            benchmark::DoNotOptimize(map->get_value_by_key(key));
+        }
+    }
+    meter.report(state, static_cast<double>(keys.size()));
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_GetValueByKey)->Apply([](auto *b) { only(b, Wide); });
+
+static void BM_ListToString(benchmark::State &state)
+{
+    ListValue *list = static_cast<ListValue *>(tree(state).root);
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        std::string text = list->to_string();
+        benchmark::DoNotOptimize(text.data());
+    }
+    meter.report(state);
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_ListToString)->Apply([](auto *b) { only(b, LongList); });
+
+// ValueUtils::print_value: render, then one Logger::log per line
+static void BM_PrintValue(benchmark::State &state)
+{
+    const synthetic::Tree &value = tree(state);
+    ValueUtils::print_value(ValueVariant(value.root));
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        ValueUtils::print_value(ValueVariant(value.root));
+    }
+    meter.report(state);
+    state.SetItemsProcessed(state.iterations() * value.nodes);
+}
+BENCHMARK(BM_PrintValue)->Apply(all_shapes);
+
+// The capture text layout, as the capture writer renders it
+static void BM_ValueToString(benchmark::State &state)
+{
+    const synthetic::Tree &value = tree(state);
+    std::string out;
+    TextEmitter warmup(out);
+    visit(value.root, warmup);
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        out.clear();
+        TextEmitter emitter(out);
+        visit(value.root, emitter);
+        benchmark::DoNotOptimize(out.data());
+    }
+    meter.report(state);
+    state.counters["bytes_out"] = static_cast<double>(out.size());
+    state.SetItemsProcessed(state.iterations() * value.nodes);
+}
+BENCHMARK(BM_ValueToString)->Apply(all_shapes);
+
+// The response hook's cost with the writer thread running: snapshot and enqueue
+static void BM_SaveResponse(benchmark::State &state)
+{
+    const synthetic::Tree &value = tree(state);
+    static synthetic::Builder builder;
+    Client *client = builder.client("127.0.0.1");
+    Request *request = builder.request("/ssc/invoke/get_inventory", "application/x-ag-binary", 200, value.root);
+
+    RequestFileLogger capture(scratch_directory("save_response").string());
+    capture.enable_logging(true);
+    CaptureOptions options;
+    options.payload = CapturePayload::AgBinary;
+    capture.start(options);
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        capture.save_response(client, request);
+    }
+    meter.report(state);
+    capture.stop();
+
+    state.counters["dropped"] = static_cast<double>(capture.stats().dropped);
+    state.SetItemsProcessed(state.iterations() * value.nodes);
+}
+BENCHMARK(BM_SaveResponse)->Apply(all_shapes);
+
+// Without start(): snapshot, encode and store write on the calling thread
+static void BM_SaveResponseInline(benchmark::State &state)
+{
+    const synthetic::Tree &value = tree(state);
+    static synthetic::Builder builder;
+    Client *client = builder.client("127.0.0.1");
+    Request *request = builder.request("/ssc/invoke/get_inventory", "application/x-ag-binary", 200, value.root);
+
+    RequestFileLogger capture(scratch_directory("save_response_inline").string());
+    capture.enable_logging(true);
+    capture.save_response(client, request);
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        capture.save_response(client, request);
+    }
+    meter.report(state);
+    state.SetItemsProcessed(state.iterations() * value.nodes);
+}
+BENCHMARK(BM_SaveResponseInline)->Apply(all_shapes);
+
+// One formatted record through Logger::log to a sink that drops it
+static void BM_LoggerLog(benchmark::State &state)
+{
+    const std::string endpoint = "/ssc/invoke/get_server_time";
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        core::logging::getLogger().log(core::logging::LogLevel::Info, std::source_location::current(),
+                                       "Making {} request to {} ({} bytes, code {})", "POST", endpoint, 1234, 200);
+    }
+    meter.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerLog);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    core::logging::getLogger().clearSinks();
+    core::logging::getLogger().addSink(std::make_shared<NullSink>());
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
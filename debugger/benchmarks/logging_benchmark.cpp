@@ -0,0 +1,79 @@
+// Caller-side cost of one log record: the synchronous text path, the async
+// text path and the deferred-formatting binary path.
+//
+// Log output goes to an in-memory ring sink so console speed is not measured.
+
+#include <benchmark/benchmark.h>
+#include <logging/logger.hpp>
+#include <logging/sinks.hpp>
+#include <filesystem>
+
+using namespace core::logging;
+
+namespace
+{
+    const std::string endpoint = "/ssc/invoke/get_server_time";
+    const std::string method = "POST";
+
+    void logTypicalRecord()
+    {
+        LOG_INFO("Making {} request to {} ({} bytes, code {})", method, endpoint, 1234, 200);
+    }
+}
+
+static void BM_TextSync(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        logTypicalRecord();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TextSync);
+
+static void BM_TextAsync(benchmark::State &state)
+{
+    getLogger().startAsync({1 << 16, OverflowPolicy::DropNewest});
+    uint64_t droppedBefore = getLogger().droppedRecords();
+
+    for (auto _ : state)
+    {
+        logTypicalRecord();
+    }
+
+    getLogger().stopAsync();
+    state.counters["dropped"] = static_cast<double>(getLogger().droppedRecords() - droppedBefore);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TextAsync);
+
+static void BM_Binary(benchmark::State &state)
+{
+    BinaryLogOptions options;
+    options.path = (std::filesystem::temp_directory_path() / "logging_benchmark.binlog").string();
+    options.threadBufferSize = 1 << 24;
+    getBinaryLogger().start(options);
+    uint64_t droppedBefore = getBinaryLogger().droppedRecords();
+
+    for (auto _ : state)
+    {
+        logTypicalRecord();
+    }
+
+    getBinaryLogger().stop();
+    state.counters["dropped"] = static_cast<double>(getBinaryLogger().droppedRecords() - droppedBefore);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Binary);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    getLogger().clearSinks();
+    getLogger().addSink(std::make_shared<RingSink>(1024));
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Decoding character-like maps (32 entries, 8 of them wanted) into a struct,
+// one IterableMap::get per field against hydra::bind's single merge-walk.
+
+#include <benchmark/benchmark.h>
+#include <hydra/binding.hpp>
+#include <synthetic/builder.hpp>
+#include <format>
+#include <vector>
+
+using namespace hydra;
+
+namespace
+{
+    struct Character
+    {
+        std::string id;
+        std::string name;
+        int64_t level = 0;
+        int64_t power = 0;
+        int64_t rank = 0;
+        int64_t tribe = 0;
+        bool alive = false;
+        std::optional<int64_t> nemesis;
+
+        static constexpr auto hydra_fields = std::tuple(
+            HYDRA_FIELD(Character, id),
+            HYDRA_FIELD(Character, name),
+            HYDRA_FIELD(Character, level),
+            HYDRA_FIELD(Character, power),
+            HYDRA_FIELD(Character, rank),
+            HYDRA_FIELD(Character, tribe),
+            HYDRA_FIELD(Character, alive),
+            HYDRA_FIELD(Character, nemesis));
+    };
+
+    // The wanted keys are spread through the map among 24 filler keys
+    const std::vector<Value *> &characters()
+    {
+        static const std::vector<Value *> values = [] {
+            // Lives as long as the process, like the values it returns
+            synthetic::Builder *builder = new synthetic::Builder();
+            std::vector<Value *> result;
+            for (int i = 0; i < 64; ++i)
+            {
+                std::vector<std::pair<std::string, Value *>> items = {
+                    {"id", builder->string(std::format("char_{:04}", i))},
+                    {"name", builder->string("Ratbag")},
+                    {"level", builder->integer(20 + i)},
+                    {"power", builder->integer(1000 * i)},
+                    {"rank", builder->integer(i % 5)},
+                    {"tribe", builder->integer(i % 8)},
+                    {"alive", builder->boolean(true)},
+                    {"nemesis", builder->integer(i)},
+                };
+                for (int filler = 0; filler < 24; ++filler)
+                {
+                    items.emplace_back(std::format("stat_{:02}", filler), builder->integer(filler));
+                }
+                result.push_back(builder->map(std::move(items)));
+            }
+            return result;
+        }();
+        return values;
+    }
+
+    void decode_with_get(IterableMap *map, Character &out)
+    {
+        out.id = map->get<std::string>("id").value_or("");
+        out.name = map->get<std::string>("name").value_or("");
+        out.level = map->get<int64_t>("level").value_or(0);
+        out.power = map->get<int64_t>("power").value_or(0);
+        out.rank = map->get<int64_t>("rank").value_or(0);
+        out.tribe = map->get<int64_t>("tribe").value_or(0);
+        out.alive = map->get<bool>("alive").value_or(false);
+        out.nemesis = map->get<int64_t>("nemesis");
+    }
+}
+
+static void BM_GetPerField(benchmark::State &state)
+{
+    const std::vector<Value *> &maps = characters();
+    Character character;
+    for (auto _ : state)
+    {
+        for (Value *map : maps)
+        {
+            decode_with_get(static_cast<IterableMap *>(map), character);
+            benchmark::DoNotOptimize(character);
+        }
+    }
+    state.counters["maps/s"] = benchmark::Counter(static_cast<double>(state.iterations() * maps.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GetPerField);
+
+static void BM_Bind(benchmark::State &state)
+{
+    const std::vector<Value *> &maps = characters();
+    Character character;
+    for (auto _ : state)
+    {
+        for (Value *map : maps)
+        {
+            BindResult result = bind(map, character);
+            benchmark::DoNotOptimize(result);
+            benchmark::DoNotOptimize(character);
+        }
+    }
+    state.counters["maps/s"] = benchmark::Counter(static_cast<double>(state.iterations() * maps.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Bind);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,145 @@
+// Rendering a response-sized value tree (an inventory-like map of ~1k nodes)
+// with the previous recursive printer and with the visitor emitters.
+//
+// Heap allocations are counted (allocation_counter.hpp) and reported per
+// node; the visitor runs should show 0 once their output buffer has grown to
+// size.
+
+#include <benchmark/benchmark.h>
+#include <hydra/value_visitor.hpp>
+#include <synthetic/builder.hpp>
+#include "allocation_counter.hpp"
+#include <format>
+#include <sstream>
+
+using namespace hydra;
+
+namespace
+{
+    using synthetic::Tree;
+    using synthetic::inventory;
+
+    // The recursive printer this replaced: an indent string and a formatted
+    // prefix per node, written through a stringstream
+    void legacy_value_to_string(const ValueVariant &value, std::stringstream &ss, const std::string &prefix = "", int indent_level = 0)
+    {
+        std::string indent(indent_level * 2, ' ');
+        switch (value.type())
+        {
+        case ValueType::Integer:
+            ss << indent << prefix << "Integer: " << value.as<int64_t>() << "\n";
+            break;
+        case ValueType::String:
+            ss << indent << prefix << "String: '" << value.as<std::string>() << "'\n";
+            break;
+        case ValueType::Map:
+        {
+            ss << indent << prefix << "Map:\n";
+            IterableMap *map = static_cast<IterableMap *>(value.get());
+            for (auto it = map->begin(); it != map->end(); ++it)
+            {
+                auto [key, child] = *it;
+                legacy_value_to_string(child, ss, std::format("'{}' => ", key), indent_level + 1);
+            }
+            break;
+        }
+        case ValueType::List:
+        {
+            ListValue *list = static_cast<ListValue *>(value.get());
+            ss << indent << prefix << "List with " << list->size() << " items:\n";
+            int index = 0;
+            for (auto it = list->begin(); it != list->end(); ++it, ++index)
+            {
+                legacy_value_to_string(*it, ss, std::format("[{}]: ", index), indent_level + 1);
+            }
+            break;
+        }
+        default:
+            ss << indent << prefix << "Unknown type\n";
+            break;
+        }
+    }
+
+    void report(benchmark::State &state, const bench::AllocationMeter &meter, size_t nodes)
+    {
+        state.counters["allocs/node"] = static_cast<double>(meter.elapsed().allocations) / static_cast<double>(state.iterations() * nodes);
+        state.counters["nodes/s"] = benchmark::Counter(static_cast<double>(state.iterations() * nodes), benchmark::Counter::kIsRate);
+    }
+
+    template <typename Emitter>
+    void render_live(benchmark::State &state)
+    {
+        const Tree &tree = inventory();
+        std::string out;
+
+        // Grow the buffer before counting
+        Emitter warmup(out);
+        visit(tree.root, warmup);
+
+        bench::AllocationMeter meter;
+        for (auto _ : state)
+        {
+            out.clear();
+            Emitter emitter(out);
+            visit(tree.root, emitter);
+            benchmark::DoNotOptimize(out.data());
+        }
+        report(state, meter, tree.nodes);
+    }
+}
+
+static void BM_LegacyText(benchmark::State &state)
+{
+    const Tree &tree = inventory();
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        std::stringstream ss;
+        legacy_value_to_string(ValueVariant(tree.root), ss);
+        std::string out = ss.str();
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state, meter, tree.nodes);
+}
+BENCHMARK(BM_LegacyText);
+
+static void BM_VisitorText(benchmark::State &state)
+{
+    render_live<TextEmitter>(state);
+}
+BENCHMARK(BM_VisitorText);
+
+static void BM_VisitorJson(benchmark::State &state)
+{
+    render_live<JsonEmitter>(state);
+}
+BENCHMARK(BM_VisitorJson);
+
+static void BM_VisitorAgBinary(benchmark::State &state)
+{
+    render_live<AgBinaryEmitter>(state);
+}
+BENCHMARK(BM_VisitorAgBinary);
+
+// The capture writer's path: the same tree rendered from its snapshot
+static void BM_VisitorTextSnapshot(benchmark::State &state)
+{
+    const Tree &tree = inventory();
+    ValueSnapshot snapshot = ValueSnapshot::capture(ValueVariant(tree.root));
+    std::string out;
+    TextEmitter warmup(out);
+    visit(snapshot.root(), warmup);
+
+    bench::AllocationMeter meter;
+    for (auto _ : state)
+    {
+        out.clear();
+        TextEmitter emitter(out);
+        visit(snapshot.root(), emitter);
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state, meter, tree.nodes);
+}
+BENCHMARK(BM_VisitorTextSnapshot);
+
+BENCHMARK_MAIN();
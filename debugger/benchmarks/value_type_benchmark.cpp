@@ -0,0 +1,167 @@
+// Classifying every node of a response-sized tree through the virtual type()
+// call and through ValueTypeCache's vftable lookup.
+//
+// The synthetic values' type() lives in this executable, so the virtual runs
+// here are a lower bound: in the game the call lands in game code.
+
+#include <benchmark/benchmark.h>
+#include <synthetic/builder.hpp>
+#include <vector>
+
+using namespace hydra;
+
+namespace
+{
+    struct VirtualCall
+    {
+        static ValueType type_of(Value *value)
+        {
+            return value->type();
+        }
+    };
+
+    // Same shape as the visitors' walk: classify, then descend into containers
+    template <typename Classifier>
+    size_t walk(Value *value)
+    {
+        size_t integers = 0;
+        switch (Classifier::type_of(value))
+        {
+        case ValueType::Integer:
+            ++integers;
+            break;
+
+        case ValueType::Map:
+        {
+            IterableMap *map = static_cast<IterableMap *>(value);
+            for (auto it = map->begin(); it != map->end(); ++it)
+            {
+                integers += walk<Classifier>(it.value().get());
+            }
+            break;
+        }
+
+        case ValueType::List:
+        {
+            ListValue *list = static_cast<ListValue *>(value);
+            for (auto it = list->begin(); it != list->end(); ++it)
+            {
+                integers += walk<Classifier>((*it).get());
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+        return integers;
+    }
+
+    void collect(Value *value, std::vector<Value *> &out)
+    {
+        out.push_back(value);
+        if (value->type() == ValueType::Map)
+        {
+            IterableMap *map = static_cast<IterableMap *>(value);
+            for (auto it = map->begin(); it != map->end(); ++it)
+            {
+                collect(it.value().get(), out);
+            }
+        }
+        else if (value->type() == ValueType::List)
+        {
+            ListValue *list = static_cast<ListValue *>(value);
+            for (auto it = list->begin(); it != list->end(); ++it)
+            {
+                collect((*it).get(), out);
+            }
+        }
+    }
+
+    template <typename Classifier>
+    void classify_tree(benchmark::State &state)
+    {
+        const synthetic::Tree &tree = synthetic::inventory();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(walk<Classifier>(tree.root));
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tree.nodes));
+    }
+}
+
+// Classification alone, over every node of the tree in walk order
+template <typename Classifier>
+static void classify_flat(benchmark::State &state)
+{
+    static const std::vector<Value *> nodes = [] {
+        std::vector<Value *> nodes;
+        collect(synthetic::inventory().root, nodes);
+        return nodes;
+    }();
+
+    for (auto _ : state)
+    {
+        uint32_t sum = 0;
+        for (Value *value : nodes)
+        {
+            sum += static_cast<uint32_t>(Classifier::type_of(value));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nodes.size()));
+}
+
+static void BM_ClassifyFlatVirtual(benchmark::State &state)
+{
+    classify_flat<VirtualCall>(state);
+}
+BENCHMARK(BM_ClassifyFlatVirtual);
+
+static void BM_ClassifyFlatCached(benchmark::State &state)
+{
+    classify_flat<ValueTypeCache>(state);
+}
+BENCHMARK(BM_ClassifyFlatCached);
+
+static void BM_ClassifyVirtual(benchmark::State &state)
+{
+    classify_tree<VirtualCall>(state);
+}
+BENCHMARK(BM_ClassifyVirtual);
+
+static void BM_ClassifyCached(benchmark::State &state)
+{
+    classify_tree<ValueTypeCache>(state);
+}
+BENCHMARK(BM_ClassifyCached);
+
+// is<T> then as<T>: two classifications per scalar, as ValueVariant users do
+static void BM_VariantIsAs(benchmark::State &state)
+{
+    const synthetic::Tree &tree = synthetic::inventory();
+    IterableMap *root = static_cast<IterableMap *>(tree.root);
+    ListValue *items = static_cast<ListValue *>(root->get_value_by_key("items"));
+
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (auto it = items->begin(); it != items->end(); ++it)
+        {
+            IterableMap *item = static_cast<IterableMap *>((*it).get());
+            for (auto entry = item->begin(); entry != item->end(); ++entry)
+            {
+                ValueVariant value = entry.value();
+                if (value.is<int64_t>())
+                {
+                    sum += value.as<int64_t>();
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * items->size() * 4));
+}
+BENCHMARK(BM_VariantIsAs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <hydra/client.hpp>
+#include <hydra/map.hpp>
+#include <hydra/request.hpp>
+#include <logging/latency_tracker.hpp>
+#include <logging/overhead_monitor.hpp>
+#include <logging/request_logger.hpp>
+
+// The detours on the game's request path. They are kept apart from the DLL
+// entry point so the replay harness (tools/hook_replay.cpp) runs this exact
+// code, with stubs in place of the game's functions.
+
+typedef void *(*request_response_fn_t)(hydra::Client *client, void *unk, hydra::Request **request_ref);
+typedef void *(*make_request_fn_t)(hydra::Client *client, std::string &endpoint, std::string &method, hydra::MapValue *data, void *a5, void *a6, void *a7);
+
+// The functions the callbacks chain to: MinHook's trampolines in the game,
+// stubs in the harness. Set before the hooks are enabled.
+extern void *original_request_response_fn;
+extern void *original_make_request_fn;
+
+extern RequestFileLogger g_file_logger;
+extern core::logging::LatencyTracker g_latency;
+// Times the callbacks and picks how much of each call they print
+extern core::logging::OverheadMonitor g_overhead;
+// Callbacks entered and not yet returned, including the call into the game's
+// function; the DLL waits for zero before it frees the trampolines and unloads
+extern std::atomic<uint32_t> g_callbacks_in_flight;
+
+void *callback_request_response(hydra::Client *client, void *unk, hydra::Request **request_ref);
+void *callback_make_request(hydra::Client *client, std::string &endpoint, std::string &method, hydra::MapValue *data, void *a5, void *a6, void *callback);
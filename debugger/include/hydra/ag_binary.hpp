@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hydra
+{
+    class ValueSnapshot;
+
+    // application/x-ag-binary, the encoding the game speaks on the wire.
+    // Same type bytes and rules as nemesis/src/codec/binary_protocol.rs and
+    // request-tester/binary_protocol.py: big-endian, one type byte per value,
+    // maps keyed by string values.
+    namespace ag_binary
+    {
+        enum class Type : uint8_t
+        {
+            Pass = 0x01,
+            BooleanFalse = 0x02,
+            BooleanTrue = 0x03,
+            U1 = 0x10,
+            S1 = 0x11,
+            U2 = 0x12,
+            S2 = 0x13,
+            U4 = 0x14,
+            S4 = 0x15,
+            S8 = 0x16,
+            U8 = 0x17,
+            Float = 0x20,
+            Double = 0x21,
+            String = 0x30,     // u1 length
+            LongString = 0x31, // u2 length
+            BinaryU1 = 0x33,
+            BinaryU2 = 0x34,
+            BinaryU4 = 0x35,
+            DateTime = 0x40,   // u4 seconds since the epoch
+            Null = 0x41,
+            Array = 0x50,      // u1 count
+            LongArray = 0x51,  // u2 count
+            Map = 0x60,        // u1 count
+            LongMap = 0x61,    // u2 count
+            Compressed = 0x67, // u1 (always 1) + binary value holding a zlib stream
+        };
+
+        // Appends the encoded tree to out. Nothing is allocated per node; out
+        // only grows when its capacity is exceeded, so reuse it across calls.
+        //
+        // DateTime and Binary nodes of decoded snapshots are written with their
+        // own type bytes and payloads. Live DateTime, Binary and Compressed
+        // nodes have no payload (their in-memory layouts are not mapped) and
+        // are written as Pass, which keeps them distinct from Null. Strings
+        // are clipped to the u2 limit at a UTF-8 code point boundary, maps and
+        // lists to u2 counts.
+        void encode(const ValueSnapshot &snapshot, std::string &out);
+
+        // Offline rendering of an encoded value; Compressed values are inflated
+        // and rendered in place. Both return false (with what was rendered so
+        // far in out) if the data is malformed or truncated.
+
+        // Same indented layout as the capture text files
+        bool to_text(std::string_view data, std::string &out);
+
+        bool to_json(std::string_view data, std::string &out);
+
+        // Decodes into a snapshot so captures can be compared and queried like
+        // live trees. Unsigned integers become Integer (wrapping above
+        // INT64_MAX), floats become Double, DateTime keeps its seconds in
+        // integer, Binary its bytes in string; Null and Pass become the 0xFF
+        // null type, Pass marked unmapped so it is encoded back as Pass.
+        // Compressed values are inflated in place.
+        bool decode(std::string_view data, ValueSnapshot &out);
+    }
+}
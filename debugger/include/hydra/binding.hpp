@@ -0,0 +1,377 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tree_access.hpp"
+
+namespace hydra
+{
+    // Typed decoding of a map into a struct that lists its fields once:
+    //
+    //   struct Reward
+    //   {
+    //       std::string type;
+    //       int64_t id = 0;
+    //       std::optional<int64_t> count;
+    //       std::vector<std::string> tags;
+    //
+    //       static constexpr auto hydra_fields = std::tuple(
+    //           HYDRA_FIELD(Reward, type),
+    //           hydra::field("rewardId", &Reward::id),
+    //           HYDRA_FIELD(Reward, count),
+    //           HYDRA_FIELD(Reward, tags));
+    //   };
+    //
+    //   Reward reward;
+    //   BindResult result = hydra::bind(map, reward);
+    //
+    // (or specialize hydra::Binding<T> with a static constexpr fields tuple,
+    // for structs that cannot be changed).
+    //
+    // The field names are sorted and checked for duplicates at compile time.
+    // On a live map each field is then one ordered descent, taken in key
+    // order; on a snapshot the entries are matched against the sorted names
+    // in a single pass. Every field is type-checked and filled once, with no
+    // std::optional or ValueVariant in between.
+    //
+    // Supported member types: bool, integers (range-checked), float and
+    // double (also from Integer), std::string, std::optional<T>, std::vector<T>
+    // from a list, other bound structs from a nested map, and the raw node
+    // (Value * or SnapshotValue). A null value counts as missing.
+    //
+    // Nothing throws. Fields that do not bind are reported in the result, with
+    // paths such as "items[2].id", except a missing optional, which is not an
+    // error. What each kind of member holds afterwards:
+    //   - plain members that are missing or hold another type keep their
+    //     previous value;
+    //   - a std::optional is reset when its value is missing or does not bind;
+    //   - a std::vector bound from a list is cleared first, then gets one
+    //     element per item; an item that does not bind stays in place,
+    //     default-constructed or partly bound. If the value is not a list,
+    //     the vector keeps its previous contents;
+    //   - a nested struct applies these rules to its own fields, or keeps all
+    //     of them if the value is not a map.
+
+    template <typename Owner, typename Member>
+    struct Field
+    {
+        std::string_view name;
+        Member Owner::*member;
+    };
+
+    template <typename Owner, typename Member>
+    constexpr Field<Owner, Member> field(std::string_view name, Member Owner::*member)
+    {
+        return {name, member};
+    }
+
+    // A field whose key is the member's own name
+#define HYDRA_FIELD(Type, member) ::hydra::field(#member, &Type::member)
+
+    template <typename T>
+    struct Binding
+    {
+    };
+
+    template <typename T>
+        requires requires { T::hydra_fields; }
+    struct Binding<T>
+    {
+        static constexpr auto fields = T::hydra_fields;
+    };
+
+    template <typename T>
+    concept Bindable = requires { Binding<T>::fields; };
+
+    struct BindIssue
+    {
+        enum class Kind : uint8_t
+        {
+            Missing,
+            TypeMismatch,
+        };
+
+        Kind kind;
+        std::string path;
+        ValueType found = static_cast<ValueType>(0xFF); // TypeMismatch only
+    };
+
+    struct BindResult
+    {
+        std::vector<BindIssue> issues;
+
+        bool ok() const
+        {
+            return issues.empty();
+        }
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        struct is_optional : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct is_optional<std::optional<T>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct is_vector : std::false_type
+        {
+        };
+
+        template <typename T, typename Allocator>
+        struct is_vector<std::vector<T, Allocator>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        inline constexpr bool always_false = false;
+
+        // The key plan for T: field names in byte-wise key order (the game
+        // map's order), each with its position in Binding<T>::fields
+        template <Bindable T>
+        struct FieldPlan
+        {
+            static constexpr auto &fields = Binding<T>::fields;
+            static constexpr size_t Count = std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>;
+
+            static constexpr std::array<std::pair<std::string_view, size_t>, Count> sorted = [] {
+                std::array<std::pair<std::string_view, size_t>, Count> entries{};
+                [&]<size_t... I>(std::index_sequence<I...>) {
+                    ((entries[I] = {std::get<I>(fields).name, I}), ...);
+                }(std::make_index_sequence<Count>());
+                std::sort(entries.begin(), entries.end());
+                return entries;
+            }();
+
+            static_assert(std::adjacent_find(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+                              return a.first == b.first;
+                          }) == sorted.end(),
+                          "Two fields are bound to the same key");
+
+            static constexpr std::array<std::string_view, Count> keys = [] {
+                std::array<std::string_view, Count> names{};
+                for (size_t i = 0; i < Count; ++i)
+                {
+                    names[i] = sorted[i].first;
+                }
+                return names;
+            }();
+        };
+
+        // One step of the path to the value being bound, linked through the
+        // callers' stack frames; only turned into a string for an issue
+        struct PathSegment
+        {
+            const PathSegment *parent;
+            std::string_view key; // Map entry, or a list element if empty
+            size_t index = 0;
+        };
+
+        inline void append_path(std::string &out, const PathSegment *segment)
+        {
+            if (!segment)
+            {
+                return;
+            }
+            append_path(out, segment->parent);
+            if (segment->key.empty())
+            {
+                out.push_back('[');
+                out += std::to_string(segment->index);
+                out.push_back(']');
+                return;
+            }
+            if (!out.empty())
+            {
+                out.push_back('.');
+            }
+            out.append(segment->key);
+        }
+
+        inline void report(BindResult &result, BindIssue::Kind kind, const PathSegment *path, ValueType found = static_cast<ValueType>(0xFF))
+        {
+            BindIssue &issue = result.issues.emplace_back(BindIssue{kind, std::string(), found});
+            append_path(issue.path, path);
+        }
+
+        template <typename Tree, Bindable T>
+        void bind_map(const typename Tree::Node &node, ValueType type, T &out, BindResult &result, const PathSegment *path);
+
+        // Reads node (of the given type, 0xFF if null) into out, or reports it
+        template <typename Tree, typename M>
+        void bind_value(const typename Tree::Node &node, ValueType type, M &out, BindResult &result, const PathSegment *path)
+        {
+            using Node = typename Tree::Node;
+
+            if constexpr (std::is_same_v<M, Node>)
+            {
+                out = node;
+            }
+            else if constexpr (is_optional<M>::value)
+            {
+                size_t issues = result.issues.size();
+                bind_value<Tree>(node, type, out.emplace(), result, path);
+                if (result.issues.size() != issues)
+                {
+                    out.reset();
+                }
+            }
+            else if constexpr (std::is_same_v<M, bool>)
+            {
+                if (type == ValueType::Boolean)
+                {
+                    out = Tree::boolean(node);
+                }
+                else
+                {
+                    report(result, BindIssue::Kind::TypeMismatch, path, type);
+                }
+            }
+            else if constexpr (std::is_integral_v<M>)
+            {
+                if (type == ValueType::Integer && std::in_range<M>(Tree::integer(node)))
+                {
+                    out = static_cast<M>(Tree::integer(node));
+                }
+                else
+                {
+                    report(result, BindIssue::Kind::TypeMismatch, path, type);
+                }
+            }
+            else if constexpr (std::is_floating_point_v<M>)
+            {
+                if (type == ValueType::Double)
+                {
+                    out = static_cast<M>(Tree::number(node));
+                }
+                else if (type == ValueType::Integer)
+                {
+                    out = static_cast<M>(Tree::integer(node));
+                }
+                else
+                {
+                    report(result, BindIssue::Kind::TypeMismatch, path, type);
+                }
+            }
+            else if constexpr (std::is_same_v<M, std::string>)
+            {
+                if (type == ValueType::String)
+                {
+                    out.assign(Tree::string(node));
+                }
+                else
+                {
+                    report(result, BindIssue::Kind::TypeMismatch, path, type);
+                }
+            }
+            else if constexpr (is_vector<M>::value)
+            {
+                if (type != ValueType::List)
+                {
+                    report(result, BindIssue::Kind::TypeMismatch, path, type);
+                    return;
+                }
+
+                out.clear();
+                PathSegment element{path, {}, 0};
+                Tree::children(node, [&](const Node &child) {
+                    ValueType child_type = Tree::valid(child) ? Tree::type(child) : static_cast<ValueType>(0xFF);
+                    bind_value<Tree>(child, child_type, out.emplace_back(), result, &element);
+                    ++element.index;
+                    return true;
+                });
+            }
+            else if constexpr (Bindable<M>)
+            {
+                bind_map<Tree>(node, type, out, result, path);
+            }
+            else
+            {
+                static_assert(always_false<M>, "Unsupported field type");
+            }
+        }
+
+        // The field at sorted position P, with everything about it known at
+        // compile time
+        template <typename Tree, typename T, size_t P>
+        void bind_field(const typename Tree::Node &child, T &out, BindResult &result, const PathSegment *path)
+        {
+            using Plan = FieldPlan<T>;
+            constexpr std::string_view key = Plan::sorted[P].first;
+            auto &member = out.*(std::get<Plan::sorted[P].second>(Plan::fields).member);
+            using Member = std::remove_cvref_t<decltype(member)>;
+
+            // A null value is as good as no value
+            ValueType type = Tree::valid(child) ? Tree::type(child) : static_cast<ValueType>(0xFF);
+            if (type == static_cast<ValueType>(0xFF))
+            {
+                if constexpr (is_optional<Member>::value)
+                {
+                    member.reset();
+                }
+                else
+                {
+                    PathSegment segment{path, key};
+                    report(result, BindIssue::Kind::Missing, &segment);
+                }
+                return;
+            }
+
+            PathSegment segment{path, key};
+            bind_value<Tree>(child, type, member, result, &segment);
+        }
+
+        template <typename Tree, Bindable T>
+        void bind_map(const typename Tree::Node &node, ValueType type, T &out, BindResult &result, const PathSegment *path)
+        {
+            using Node = typename Tree::Node;
+            using Plan = FieldPlan<T>;
+
+            if (type != ValueType::Map)
+            {
+                report(result, BindIssue::Kind::TypeMismatch, path, type);
+                return;
+            }
+
+            std::array<Node, Plan::Count> values{};
+            Tree::lookup(node, Plan::keys, values);
+            [&]<size_t... P>(std::index_sequence<P...>) {
+                (bind_field<Tree, T, P>(values[P], out, result, path), ...);
+            }(std::make_index_sequence<Plan::Count>());
+        }
+
+        template <typename Tree, Bindable T>
+        BindResult bind_root(const typename Tree::Node &node, T &out)
+        {
+            BindResult result;
+            ValueType type = Tree::valid(node) ? Tree::type(node) : static_cast<ValueType>(0xFF);
+            bind_map<Tree>(node, type, out, result, nullptr);
+            return result;
+        }
+    }
+
+    // Fills out from a map; see the top of this file
+    template <Bindable T>
+    BindResult bind(Value *map, T &out)
+    {
+        return detail::bind_root<detail::LiveTree>(map, out);
+    }
+
+    template <Bindable T>
+    BindResult bind(const SnapshotValue &map, T &out)
+    {
+        return detail::bind_root<detail::SnapshotTree>(map, out);
+    }
+}
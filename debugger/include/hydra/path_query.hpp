@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "snapshot.hpp"
+#include "value.hpp"
+
+namespace hydra
+{
+    // A path expression compiled once into a list of steps, which can then be
+    // run any number of times against live trees or snapshots:
+    //
+    //   data.characters[*].nemesis.level     level of every character's nemesis
+    //   rewards[?type=="gear"].id            ids of the rewards with type "gear"
+    //   items[-1]                            last element of items
+    //   loadouts.*                           every value of the loadouts map
+    //
+    // Grammar:
+    //   path     := key ( '.' key | '[' selector ']' )*   (the leading key is optional)
+    //   key      := name | '"' quoted name '"' | '*'
+    //   selector := integer | '"' quoted name '"' | '*' | '?' field op literal
+    //   field    := key ( '.' key )*                      relative to the element
+    //   op       := '==' | '!=' | '<' | '<=' | '>' | '>='
+    //   literal  := '"' string '"' | integer | decimal | 'true' | 'false'
+    //
+    // A name runs up to the next '.', '[', ']', space or comparison operator;
+    // quote keys containing those, or write them as ["key"]. Negative indices
+    // count from the end. '*' and filters apply to the children of a list, or
+    // to the values of a map in key order. Filters compare integers and
+    // doubles numerically and strings byte-wise; an element whose field is
+    // missing or of another type never matches.
+    //
+    // Map keys are resolved with the game map's ordered descent
+    // (MapValue::find_entry), so a path of keys costs one O(log n) lookup per
+    // step; nothing is copied or allocated while a query runs except growth
+    // of the caller's result vector. A path that does not resolve selects
+    // nothing.
+    class PathQuery
+    {
+    public:
+        // Returns std::nullopt (and a description in error, if given) when the
+        // expression does not parse
+        static std::optional<PathQuery> compile(std::string_view expression, std::string *error = nullptr);
+
+        const std::string &expression() const
+        {
+            return m_expression;
+        }
+
+        // Appends every match in document order; returns the number appended
+        size_t select(Value *root, std::vector<Value *> &out) const;
+        size_t select(const SnapshotValue &root, std::vector<SnapshotValue> &out) const;
+
+        // First match only, stopping as soon as it is found; nullptr / invalid if none
+        Value *first(Value *root) const;
+        SnapshotValue first(const SnapshotValue &root) const;
+
+        // First match, if it holds a T
+        template <typename T>
+        std::optional<T> get(Value *root) const
+        {
+            ValueVariant value(first(root));
+            if (!value.is<T>())
+            {
+                return std::nullopt;
+            }
+            return value.as<T>();
+        }
+
+        template <typename T>
+        std::optional<T> get(const SnapshotValue &root) const
+        {
+            SnapshotValue value = first(root);
+            if (!value.is<T>())
+            {
+                return std::nullopt;
+            }
+            return value.as<T>();
+        }
+
+        enum class Compare : uint8_t
+        {
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+        };
+
+        struct Literal
+        {
+            enum class Kind : uint8_t
+            {
+                String,
+                Integer,
+                Double,
+                Boolean,
+            };
+
+            Kind kind = Kind::Integer;
+            std::string string;
+            int64_t integer = 0;
+            double number = 0.0;
+            bool boolean = false;
+        };
+
+        struct Step
+        {
+            enum class Kind : uint8_t
+            {
+                Key,      // Map value by key
+                Index,    // List element by position
+                Children, // '*': every list element or map value
+                Filter,   // '[?...]': the children whose field compares true
+            };
+
+            Kind kind;
+            std::string key;
+            int64_t index = 0;
+
+            // Filter only: the field's path of keys, the comparison and its operand
+            std::vector<std::string> field;
+            Compare compare = Compare::Equal;
+            Literal literal;
+        };
+
+        const std::vector<Step> &steps() const
+        {
+            return m_steps;
+        }
+
+    private:
+        PathQuery() = default;
+
+        std::string m_expression;
+        std::vector<Step> m_steps;
+    };
+}
@@ -15,7 +15,7 @@ namespace hydra
 
         ValueVariant get_data() const 
         {
-            return ValueVariant(data);
+            return ValueVariant(data());
         }
     };
 }
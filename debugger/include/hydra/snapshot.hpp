@@ -0,0 +1,338 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "value.hpp"
+
+namespace hydra
+{
+    class SnapshotValue;
+
+    // Owned, pointer-free copy of a value tree, taken while the game's tree is
+    // still alive so it can be consumed later on another thread.
+    //
+    // The tree is flattened into a tape in pre-order: a Map or List node is
+    // followed by its child_count children (each with their own subtrees), and
+    // every node records the index just past its subtree so readers can step
+    // over it in O(1). Map children carry their key; all string bytes live in
+    // one blob after the nodes.
+    //
+    // Nodes and strings share a single allocation, so moving a snapshot
+    // through a queue is a pointer swap and freeing it is one delete.
+    class ValueSnapshot
+    {
+    public:
+        static constexpr uint32_t NoKey = UINT32_MAX;
+
+        struct Node
+        {
+            ValueType type;
+            // A live DateTime, Binary or Compressed node (or a decoded Pass):
+            // its layout is not mapped, so no payload was kept. Decoded
+            // DateTime nodes hold their seconds in integer, Binary their bytes
+            // in string.
+            bool unmapped = false;
+            uint32_t key_offset = NoKey;
+            uint32_t key_length = 0;
+            uint32_t child_count = 0;
+            uint32_t end = 0; // Index of the node following this subtree
+            union
+            {
+                int64_t integer;
+                double number;
+                bool boolean;
+                struct
+                {
+                    uint32_t offset;
+                    uint32_t length;
+                } string;
+            };
+
+            Node() : integer(0) {}
+        };
+
+        static_assert(std::is_trivially_copyable_v<Node>);
+
+        ValueSnapshot() = default;
+
+        // A moved-from snapshot is empty, not a node count over a null arena
+        ValueSnapshot(ValueSnapshot &&other) noexcept
+            : m_arena(std::move(other.m_arena)),
+              m_arena_words(std::exchange(other.m_arena_words, 0)),
+              m_node_count(std::exchange(other.m_node_count, 0)),
+              m_strings(std::exchange(other.m_strings, nullptr))
+        {
+        }
+
+        ValueSnapshot &operator=(ValueSnapshot &&other) noexcept
+        {
+            if (this != &other)
+            {
+                m_arena = std::move(other.m_arena);
+                m_arena_words = std::exchange(other.m_arena_words, 0);
+                m_node_count = std::exchange(other.m_node_count, 0);
+                m_strings = std::exchange(other.m_strings, nullptr);
+            }
+            return *this;
+        }
+
+        static ValueSnapshot capture(const ValueVariant &root);
+
+        // Adopts a tape built elsewhere (e.g. decoded from a capture). Nodes
+        // must be in the layout described above, with string and key offsets
+        // into strings.
+        static ValueSnapshot from_tape(std::span<const Node> nodes, std::string_view strings);
+
+        bool empty() const
+        {
+            return m_node_count == 0;
+        }
+
+        std::span<const Node> nodes() const
+        {
+            return {reinterpret_cast<const Node *>(m_arena.get()), m_node_count};
+        }
+
+        // Read access in the shape of ValueVariant; invalid if empty
+        SnapshotValue root() const;
+
+        std::string_view key(const Node &node) const
+        {
+            return node.key_offset == NoKey ? std::string_view() : text(node.key_offset, node.key_length);
+        }
+
+        std::string_view string(const Node &node) const
+        {
+            return text(node.string.offset, node.string.length);
+        }
+
+        // Heap bytes held by this snapshot (used for queue accounting)
+        size_t byte_size() const
+        {
+            return m_arena_words * sizeof(uint64_t);
+        }
+
+    private:
+        class Builder;
+
+        std::string_view text(uint32_t offset, uint32_t length) const
+        {
+            return std::string_view(m_strings + offset, length);
+        }
+
+        std::unique_ptr<uint64_t[]> m_arena;
+        size_t m_arena_words = 0;
+        uint32_t m_node_count = 0;
+        const char *m_strings = nullptr;
+    };
+
+    // A node of a snapshot, mirroring ValueVariant (is/as), ListValue (size,
+    // at, iteration) and IterableMap (get, contains, iteration with key()).
+    // Cheap to copy; valid for as long as the snapshot is alive.
+    class SnapshotValue
+    {
+    public:
+        class Iterator
+        {
+        public:
+            Iterator(const ValueSnapshot *snapshot, uint32_t index) : m_snapshot(snapshot), m_index(index) {}
+
+            SnapshotValue operator*() const
+            {
+                return SnapshotValue(m_snapshot, m_index);
+            }
+
+            // Steps over the whole subtree of the current child
+            Iterator &operator++()
+            {
+                m_index = m_snapshot->nodes()[m_index].end;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const
+            {
+                return m_index == other.m_index;
+            }
+
+            bool operator!=(const Iterator &other) const
+            {
+                return !(*this == other);
+            }
+
+            // Key of the current map entry
+            std::string_view key() const
+            {
+                return m_snapshot->key(m_snapshot->nodes()[m_index]);
+            }
+
+        private:
+            const ValueSnapshot *m_snapshot;
+            uint32_t m_index;
+        };
+
+        SnapshotValue() = default;
+        SnapshotValue(const ValueSnapshot *snapshot, uint32_t index) : m_snapshot(snapshot), m_index(index) {}
+
+        bool valid() const
+        {
+            return m_snapshot && m_index < m_snapshot->nodes().size();
+        }
+
+        ValueType type() const
+        {
+            return node().type;
+        }
+
+        // Key under which this value sits in its parent map, empty otherwise
+        std::string_view key() const
+        {
+            return m_snapshot->key(node());
+        }
+
+        bool unmapped() const
+        {
+            return valid() && node().unmapped;
+        }
+
+        // Payloads of DateTime (seconds since the epoch) and Binary nodes that
+        // are not unmapped()
+        int64_t datetime() const
+        {
+            return node().integer;
+        }
+
+        std::string_view bytes() const
+        {
+            return m_snapshot->string(node());
+        }
+
+        template <typename T>
+        bool is() const;
+
+        // Strings are returned as views into the snapshot; std::string copies
+        template <typename T>
+        T as() const;
+
+        // Children of a map or list (0 for scalars)
+        size_t size() const
+        {
+            return valid() ? node().child_count : 0;
+        }
+
+        Iterator begin() const
+        {
+            return Iterator(m_snapshot, valid() ? m_index + 1 : 0);
+        }
+
+        Iterator end() const
+        {
+            return Iterator(m_snapshot, valid() ? node().end : 0);
+        }
+
+        // List element; invalid if out of range. Linear in index, but each
+        // step skips a whole subtree.
+        SnapshotValue at(size_t index) const;
+
+        // Map entry by key; invalid if absent or not a map. Linear in the
+        // map's entries: each miss steps over the entry's whole subtree by its
+        // end offset. There is no early stop, since decoded captures need not
+        // be in key order.
+        SnapshotValue find(std::string_view key) const;
+
+        bool contains(std::string_view key) const
+        {
+            return find(key).valid();
+        }
+
+        template <typename T>
+        std::optional<T> get(std::string_view key) const
+        {
+            SnapshotValue value = find(key);
+            if (!value.valid() || !value.is<T>())
+            {
+                return std::nullopt;
+            }
+            return value.as<T>();
+        }
+
+    private:
+        const ValueSnapshot::Node &node() const
+        {
+            return m_snapshot->nodes()[m_index];
+        }
+
+        const ValueSnapshot *m_snapshot = nullptr;
+        uint32_t m_index = 0;
+    };
+
+    inline SnapshotValue ValueSnapshot::root() const
+    {
+        return empty() ? SnapshotValue() : SnapshotValue(this, 0);
+    }
+
+    template <typename T>
+    bool SnapshotValue::is() const
+    {
+        if (!valid())
+        {
+            return false;
+        }
+
+        if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return type() == ValueType::Integer;
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return type() == ValueType::Double;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return type() == ValueType::Boolean;
+        }
+        else if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+        {
+            return type() == ValueType::String;
+        }
+        return false;
+    }
+
+    template <typename T>
+    T SnapshotValue::as() const
+    {
+        if (!is<T>())
+        {
+            throw std::bad_cast();
+        }
+
+        if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return node().integer;
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            return node().number;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return node().boolean;
+        }
+        else if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            return m_snapshot->string(node());
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            return std::string(m_snapshot->string(node()));
+        }
+        else
+        {
+            return T{};
+        }
+    }
+}
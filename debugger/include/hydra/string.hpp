@@ -12,12 +12,12 @@ namespace hydra
 
         bool empty()
         {
-            return this->string.empty();
+            return this->string().empty();
         }
 
         std::string to_string()
         {
-            return this->string;
+            return this->string();
         }
     };
 }
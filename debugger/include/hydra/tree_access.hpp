@@ -0,0 +1,232 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "snapshot.hpp"
+#include "value.hpp"
+
+namespace hydra::detail
+{
+    // The same read operations over the game's live tree (Value *) and over
+    // snapshots (SnapshotValue), so one templated algorithm serves both.
+    // Lookups return an invalid node rather than throwing.
+
+    // Index into a container of size elements; negative counts from the end
+    inline bool resolve_index(int64_t index, size_t size, size_t &out)
+    {
+        if (index < 0)
+        {
+            index += static_cast<int64_t>(size);
+        }
+        if (index < 0 || static_cast<uint64_t>(index) >= size)
+        {
+            return false;
+        }
+        out = static_cast<size_t>(index);
+        return true;
+    }
+
+    struct LiveTree
+    {
+        using Node = Value *;
+
+        static bool valid(Node node)
+        {
+            return node != nullptr;
+        }
+
+        static ValueType type(Node node)
+        {
+            return ValueTypeCache::type_of(node);
+        }
+
+        static Node child(Node node, std::string_view key)
+        {
+            return type(node) == ValueType::Map ? static_cast<MapValue *>(node)->get_value_by_key(key) : nullptr;
+        }
+
+        // out[i] = value of sorted_keys[i], or nullptr. One ordered descent
+        // per key: on maps of a few dozen entries this beats both a shared
+        // descent (get_many) and an in-order merge walk, and touches the same
+        // nodes, as the upper levels stay cached between keys.
+        static void lookup(Node node, std::span<const std::string_view> sorted_keys, std::span<Node> out)
+        {
+            if (type(node) != ValueType::Map)
+            {
+                return;
+            }
+            MapValue *map = static_cast<MapValue *>(node);
+            for (size_t i = 0; i < sorted_keys.size(); ++i)
+            {
+                out[i] = map->get_value_by_key(sorted_keys[i]);
+            }
+        }
+
+        static Node element(Node node, int64_t index)
+        {
+            size_t position;
+            if (type(node) != ValueType::List)
+            {
+                return nullptr;
+            }
+            const std::vector<Value *> &values = static_cast<ListValue *>(node)->get_list()->values;
+            return resolve_index(index, values.size(), position) ? values[position] : nullptr;
+        }
+
+        // Calls visit for each list element or map value until it returns false
+        template <typename Visit>
+        static void children(Node node, Visit &&visit)
+        {
+            switch (type(node))
+            {
+            case ValueType::Map:
+                entries(node, [&](std::string_view, Node child) { return visit(child); });
+                break;
+            case ValueType::List:
+                for (Value *value : static_cast<ListValue *>(node)->get_list()->values)
+                {
+                    if (!visit(value))
+                    {
+                        return;
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Calls visit(key, value) for each map entry until it returns false
+        template <typename Visit>
+        static void entries(Node node, Visit &&visit)
+        {
+            if (type(node) != ValueType::Map)
+            {
+                return;
+            }
+            IterableMap *map = static_cast<IterableMap *>(node);
+            for (auto it = map->begin(); it != map->end(); ++it)
+            {
+                if (!visit(it.key(), (*it).second.get()))
+                {
+                    return;
+                }
+            }
+        }
+
+        static int64_t integer(Node node)
+        {
+            return static_cast<IntegerValue *>(node)->value();
+        }
+
+        static double number(Node node)
+        {
+            return static_cast<DoubleValue *>(node)->value;
+        }
+
+        static bool boolean(Node node)
+        {
+            return static_cast<BooleanValue *>(node)->value;
+        }
+
+        static std::string_view string(Node node)
+        {
+            return static_cast<StringValue *>(node)->value;
+        }
+    };
+
+    struct SnapshotTree
+    {
+        using Node = SnapshotValue;
+
+        static bool valid(const Node &node)
+        {
+            return node.valid();
+        }
+
+        static ValueType type(const Node &node)
+        {
+            return node.type();
+        }
+
+        static Node child(const Node &node, std::string_view key)
+        {
+            return node.find(key);
+        }
+
+        // Decoded captures keep the server's key order and a snapshot map has
+        // no index, so this is one pass over the entries, each looked up in
+        // the sorted keys
+        static void lookup(const Node &node, std::span<const std::string_view> sorted_keys, std::span<Node> out)
+        {
+            entries(node, [&](std::string_view key, const Node &child) {
+                auto it = std::lower_bound(sorted_keys.begin(), sorted_keys.end(), key);
+                if (it != sorted_keys.end() && *it == key)
+                {
+                    out[it - sorted_keys.begin()] = child;
+                }
+                return true;
+            });
+        }
+
+        static Node element(const Node &node, int64_t index)
+        {
+            size_t position;
+            if (node.type() != ValueType::List || !resolve_index(index, node.size(), position))
+            {
+                return SnapshotValue();
+            }
+            return node.at(position);
+        }
+
+        template <typename Visit>
+        static void children(const Node &node, Visit &&visit)
+        {
+            for (auto it = node.begin(); it != node.end(); ++it)
+            {
+                if (!visit(*it))
+                {
+                    return;
+                }
+            }
+        }
+
+        template <typename Visit>
+        static void entries(const Node &node, Visit &&visit)
+        {
+            if (!node.valid() || node.type() != ValueType::Map)
+            {
+                return;
+            }
+            for (auto it = node.begin(); it != node.end(); ++it)
+            {
+                if (!visit(it.key(), *it))
+                {
+                    return;
+                }
+            }
+        }
+
+        static int64_t integer(const Node &node)
+        {
+            return node.as<int64_t>();
+        }
+
+        static double number(const Node &node)
+        {
+            return node.as<double>();
+        }
+
+        static bool boolean(const Node &node)
+        {
+            return node.as<bool>();
+        }
+
+        static std::string_view string(const Node &node)
+        {
+            return node.as<std::string_view>();
+        }
+    };
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -8,8 +9,8 @@
 #include <type_traits>
 #include <stdexcept>
 #include <utils/macros.hpp>
-#include <queue>
-#include <unordered_set>
+#include <span>
+#include <string_view>
 #include <logging/logger.hpp>
 
 namespace hydra
@@ -45,6 +46,57 @@ namespace hydra
         std::string get_type_name();
     };
 
+    // Classifies values by the vftable pointer at offset 0 instead of a
+    // virtual type() call into the game. Each class's type() is constant, so
+    // the first answer seen for a vftable is kept in a small lock-free table;
+    // later lookups are a load and a compare. Vftables not in the table (or
+    // past its capacity) fall back to the virtual call.
+    class ValueTypeCache
+    {
+    public:
+        static ValueType type_of(Value *value)
+        {
+            uintptr_t vftable = *reinterpret_cast<const uintptr_t *>(value);
+            for (size_t probe = 0, slot = home_slot(vftable); probe < Slots; ++probe, slot = (slot + 1) % Slots)
+            {
+                uint64_t entry = m_slots[slot].load(std::memory_order_acquire);
+                if (entry == 0)
+                {
+                    break;
+                }
+                if ((entry & AddressMask) == vftable)
+                {
+                    return static_cast<ValueType>(entry >> TypeShift);
+                }
+            }
+            return learn(value, vftable);
+        }
+
+        // Forgets every learned vftable (benchmarks, or after a module reload)
+        static void clear();
+
+    private:
+        static ValueType learn(Value *value, uintptr_t vftable);
+
+        // Open addressing from a multiplicative hash, so a lookup is usually
+        // a single probe
+        static size_t home_slot(uintptr_t vftable)
+        {
+            return static_cast<size_t>((static_cast<uint64_t>(vftable) * 0x9E3779B97F4A7C15ull) >> (64 - SlotBits));
+        }
+
+        // Ten value classes exist; the spare slots absorb any duplicates from
+        // two threads learning the same vftable at once
+        static constexpr int SlotBits = 4;
+        static constexpr size_t Slots = size_t(1) << SlotBits;
+
+        // Entries pack the type into the top byte above a user-mode address
+        static constexpr int TypeShift = 56;
+        static constexpr uint64_t AddressMask = (1ull << TypeShift) - 1;
+
+        static inline std::atomic<uint64_t> m_slots[Slots]{};
+    };
+
     class IntegerValue : public Value
     {
     public:
@@ -105,119 +157,166 @@ namespace hydra
         MapEntry *sentinel;
         int32_t num_entries;
 
-        Value *get_value_by_key(const std::string &key_str)
+        // Bound on the depth of a red-black tree of any size that fits in memory
+        // (at most 2*log2(n+1)); walks stop at this depth rather than trusting a
+        // corrupt tree
+        static constexpr size_t MaxTreeDepth = 96;
+
+        // The std::map header node: its parent link (padding01) is the root and
+        // every leaf's child links point back to it
+        MapEntry *head() const
         {
-            MapEntry *map_data = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(this) + 0x8);
-            MapEntry *map_data_1 = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(map_data) + 0x8);
+            return *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(this) + 0x8);
+        }
 
-            while (!*reinterpret_cast<bool *>(reinterpret_cast<uintptr_t>(map_data_1) + 0x19))
-            {
-                StringValue *cur_key = *reinterpret_cast<StringValue **>(reinterpret_cast<uintptr_t>(map_data_1) + 0x20);
-                if (cur_key->to_string() == key_str)
-                {
-                    map_data_1 = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(map_data_1) + 0x10);
-                }
-                else
-                {
-                    map_data = map_data_1;
-                    map_data_1 = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(map_data_1));
-                }
-            }
+        static bool is_nil(const MapEntry *node)
+        {
+            return !node || node->is_last;
+        }
 
-            if (map_data == *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(this) + 0x8))
+        // Ordered descent comparing in place against the stored keys; nothing is
+        // copied or allocated. Returns nullptr if the key is absent.
+        MapEntry *find_entry(std::string_view key) const
+        {
+            MapEntry *node_head = head();
+            if (!node_head)
             {
                 return nullptr;
             }
 
-            StringValue *found_key = *reinterpret_cast<StringValue **>(reinterpret_cast<uintptr_t>(map_data) + 0x20);
-            if (found_key->to_string() != key_str)
+            MapEntry *node = static_cast<MapEntry *>(node_head->padding01);
+            for (size_t depth = 0; !is_nil(node) && depth < MaxTreeDepth; ++depth)
             {
-                return nullptr;
+                int order = key.compare(node->key->value);
+                if (order == 0)
+                {
+                    return node;
+                }
+                node = order < 0 ? node->left_child : node->right_child;
             }
+            return nullptr;
+        }
 
-            return *reinterpret_cast<Value **>(reinterpret_cast<uintptr_t>(map_data) + 0x28);
+        Value *get_value_by_key(std::string_view key) const
+        {
+            MapEntry *entry = find_entry(key);
+            return entry ? entry->value : nullptr;
         }
+
+        // Resolves several keys in shared descents: keys are sorted, then split
+        // around each node on the way down, so common path prefixes are walked
+        // once. values[i] receives keys[i]'s value or nullptr; values must be at
+        // least as long as keys. Returns the number of keys found.
+        size_t get_many(std::span<const std::string_view> keys, std::span<Value *> values) const;
     };
 
+    // In-order (key-ordered) walk of the game's red-black tree. Nothing is
+    // copied or allocated: the path from the root to the current entry is kept
+    // in a fixed stack, and keys are views into the game's own strings, valid
+    // for as long as the map is not modified.
+    //
+    // The stack holds MapValue::MaxTreeDepth entries, enough for any valid
+    // red-black tree. A deeper (corrupt) tree ends the walk early; truncated()
+    // then reports it and a warning is logged.
     class MapIterator
     {
     private:
-        std::vector<std::pair<std::string, Value *>> m_entries;
-        size_t m_index;
+        static constexpr size_t MaxDepth = MapValue::MaxTreeDepth;
+
+        MapEntry *m_stack[MaxDepth];
+        size_t m_depth;
+        bool m_truncated = false;
+
+        void overflow()
+        {
+            m_depth = 0;
+            m_truncated = true;
+            LOG_WARN("Map deeper than {} levels; iteration stopped early", MaxDepth);
+        }
+
+        void push_left(MapEntry *node)
+        {
+            while (!MapValue::is_nil(node))
+            {
+                if (m_depth == MaxDepth)
+                {
+                    overflow();
+                    return;
+                }
+                m_stack[m_depth++] = node;
+                node = node->left_child;
+            }
+        }
+
+        MapEntry *current() const
+        {
+            return m_depth ? m_stack[m_depth - 1] : nullptr;
+        }
 
     public:
         MapIterator(MapValue *map, bool begin = true)
         {
-            m_index = 0;
+            m_depth = 0;
 
             if (!map || !begin)
             {
                 return; // Empty iterator or end iterator
             }
 
-            MapEntry *sentinel = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(map) + 0x8);
-            if (!sentinel)
+            MapEntry *head = map->head();
+            if (!head)
             {
                 return;
             }
 
-            MapEntry *first_node = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(sentinel) + 0x8);
-            if (!first_node || first_node == sentinel)
+            push_left(static_cast<MapEntry *>(head->padding01));
+        }
+
+        // Positions on the first entry whose key satisfies at_or_after, which
+        // must be false for a prefix of the key order and true for the rest.
+        // One descent from the root leaves exactly the stack an in-order walk
+        // would have there, so iteration continues from it in O(1) amortized.
+        template <typename AtOrAfter>
+        static MapIterator seek(MapValue *map, AtOrAfter at_or_after)
+        {
+            MapIterator it(map, false);
+            MapEntry *head = map ? map->head() : nullptr;
+            if (!head)
             {
-                return;
+                return it;
             }
 
-            std::queue<MapEntry *> queue;
-            std::unordered_set<MapEntry *> visited;
-
-            queue.push(first_node);
-            visited.insert(first_node);
-
-            while (!queue.empty())
+            MapEntry *node = static_cast<MapEntry *>(head->padding01);
+            while (!MapValue::is_nil(node))
             {
-                MapEntry *node = queue.front();
-                queue.pop();
-
-                if (node == sentinel)
+                if (it.m_depth == MaxDepth)
                 {
-                    continue;
+                    it.overflow();
+                    break;
                 }
 
-                // Extract key-value pair
-                StringValue *key = *reinterpret_cast<StringValue **>(reinterpret_cast<uintptr_t>(node) + 0x20);
-                Value *value = *reinterpret_cast<Value **>(reinterpret_cast<uintptr_t>(node) + 0x28);
-
-                m_entries.push_back({key->to_string(), value});
-
-                // Add unvisited children to queue
-                bool is_last = *reinterpret_cast<bool *>(reinterpret_cast<uintptr_t>(node) + 0x19);
-                if (!is_last)
+                if (at_or_after(std::string_view(node->key->value)))
                 {
-                    MapEntry *left = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(node) + 0x00);
-                    if (left && left != sentinel && visited.find(left) == visited.end())
-                    {
-                        queue.push(left);
-                        visited.insert(left);
-                    }
-
-                    MapEntry *right = *reinterpret_cast<MapEntry **>(reinterpret_cast<uintptr_t>(node) + 0x10);
-                    if (right && right != sentinel && visited.find(right) == visited.end())
-                    {
-                        queue.push(right);
-                        visited.insert(right);
-                    }
+                    it.m_stack[it.m_depth++] = node;
+                    node = node->left_child;
+                }
+                else
+                {
+                    node = node->right_child;
                 }
             }
+            return it;
         }
 
-        // Return a pair of string and ValueVariant
-        std::pair<std::string, ValueVariant> operator*() const;
+        // Return a pair of key and ValueVariant
+        std::pair<std::string_view, ValueVariant> operator*() const;
 
         MapIterator &operator++()
         {
-            if (m_index < m_entries.size())
+            if (m_depth)
             {
-                ++m_index;
+                MapEntry *node = m_stack[--m_depth];
+                push_left(node->right_child);
             }
             return *this;
         }
@@ -231,11 +330,7 @@ namespace hydra
 
         bool operator==(const MapIterator &other) const
         {
-            if (m_index >= m_entries.size() && other.m_index >= other.m_entries.size())
-            {
-                return true;
-            }
-            return m_index == other.m_index && m_entries.size() == other.m_entries.size();
+            return current() == other.current();
         }
 
         bool operator!=(const MapIterator &other) const
@@ -243,18 +338,43 @@ namespace hydra
             return !(*this == other);
         }
 
-        std::string key() const
+        // True once the walk has ended early on a tree deeper than any valid
+        // one; the entries seen so far are not the whole map
+        bool truncated() const
+        {
+            return m_truncated;
+        }
+
+        std::string_view key() const
         {
-            if (m_index >= m_entries.size())
+            MapEntry *node = current();
+            if (!node)
             {
                 throw std::runtime_error("Accessing key of invalid iterator");
             }
-            return m_entries[m_index].first;
+            return node->key->value;
         }
 
         ValueVariant value() const;
     };
 
+    // Half-open slice [first, last) of a map, usable in range-for
+    struct MapRange
+    {
+        MapIterator first;
+        MapIterator last;
+
+        MapIterator begin() const
+        {
+            return first;
+        }
+
+        MapIterator end() const
+        {
+            return last;
+        }
+    };
+
     class IterableMap : public MapValue
     {
     public:
@@ -267,14 +387,41 @@ namespace hydra
         {
             return MapIterator(this, false);
         }
+
+        // Ordered queries: one O(log n) descent each, then O(1) amortized per
+        // entry visited. Same ordering as the game's map (byte-wise compare).
+
+        // First entry with key >= key
+        MapIterator lower_bound(std::string_view key)
+        {
+            return MapIterator::seek(this, [key](std::string_view entry) { return entry >= key; });
+        }
+
+        // First entry with key > key
+        MapIterator upper_bound(std::string_view key)
+        {
+            return MapIterator::seek(this, [key](std::string_view entry) { return entry > key; });
+        }
+
+        MapRange equal_range(std::string_view key)
+        {
+            return {lower_bound(key), upper_bound(key)};
+        }
+
+        // Entries whose key starts with prefix, e.g. prefix_scan("loadout_").
+        // They are contiguous in key order; the end is the first key past them.
+        MapRange prefix_scan(std::string_view prefix)
+        {
+            return {lower_bound(prefix),
+                    MapIterator::seek(this, [prefix](std::string_view entry) { return entry > prefix && !entry.starts_with(prefix); })};
+        }
         
         template <typename T>
-        std::optional<T> get(const std::string &key);
+        std::optional<T> get(std::string_view key);
 
-        bool contains(const std::string &key)
+        bool contains(std::string_view key) const
         {
-            // return get_value_by_key(key) != nullptr;
-            return false;
+            return find_entry(key) != nullptr;
         }
     };
 
@@ -21,7 +21,7 @@ std::vector<T> List::to_vector() const
 template <typename T>
 bool ListValue::all_of_type() const
 {
-    for (auto it = list.begin(); it != list.end(); ++it)
+    for (auto it = list()->begin(); it != list()->end(); ++it)
     {
         ValueVariant value = *it;
         if (!value.is<T>())
@@ -41,9 +41,9 @@ std::optional<std::vector<T>> ListValue::as_vector() const
     }
 
     std::vector<T> result;
-    result.reserve(list.size());
+    result.reserve(list()->size());
 
-    for (auto it = list.begin(); it != list.end(); ++it)
+    for (auto it = list()->begin(); it != list()->end(); ++it)
     {
         ValueVariant value = *it;
         result.push_back(value.as<T>());
@@ -59,46 +59,48 @@ bool ValueVariant::is() const
     if (!m_value)
         return false;
 
+    ValueType type = ValueTypeCache::type_of(m_value);
+
     // Map ValueType to actual C++ type
     if constexpr (std::is_same_v<T, int64_t>)
     {
-        return m_value->type() == ValueType::Integer;
+        return type == ValueType::Integer;
     }
     else if constexpr (std::is_same_v<T, double>)
     {
-        return m_value->type() == ValueType::Double;
+        return type == ValueType::Double;
     }
     else if constexpr (std::is_same_v<T, bool>)
     {
-        return m_value->type() == ValueType::Boolean;
+        return type == ValueType::Boolean;
     }
     else if constexpr (std::is_same_v<T, std::string>)
     {
-        return m_value->type() == ValueType::String;
+        return type == ValueType::String;
     }
     else if constexpr (std::is_same_v<T, Map *>)
     {
-        return m_value->type() == ValueType::Map;
+        return type == ValueType::Map;
     }
     else if constexpr (std::is_same_v<T, ListValue *>)
     {
-        return m_value->type() == ValueType::List;
+        return type == ValueType::List;
     }
     else if constexpr (std::is_same_v<T, std::chrono::system_clock::time_point>)
     {
-        return m_value->type() == ValueType::DateTime ||
-               m_value->type() == ValueType::HiResDateTime;
+        return type == ValueType::DateTime ||
+               type == ValueType::HiResDateTime;
     }
     else if constexpr (std::is_same_v<T, std::vector<uint8_t>>)
     {
-        return m_value->type() == ValueType::Binary;
+        return type == ValueType::Binary;
     }
 
     return false;
 }
 
 template <typename T>
-std::optional<T> IterableMap::get(const std::string &key)
+std::optional<T> IterableMap::get(std::string_view key)
 {
     Value *value = get_value_by_key(key);
     if (!value)
@@ -125,7 +127,7 @@ T ValueVariant::as() const
 
     if constexpr (std::is_same_v<T, int64_t>)
     {
-        return static_cast<IntegerValue *>(m_value)->value;
+        return static_cast<IntegerValue *>(m_value)->value();
     }
     else if constexpr (std::is_same_v<T, double>)
     {
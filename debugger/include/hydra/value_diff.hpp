@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "snapshot.hpp"
+
+namespace hydra
+{
+    // One difference between two value trees. Paths use the same shape as
+    // the text dumps: map keys joined by '.', list elements as "[index]", e.g.
+    // "items[3].id"; the root itself is the empty path.
+    struct ValueDifference
+    {
+        enum class Kind : uint8_t
+        {
+            Added,   // Only in the new tree; old_value is invalid
+            Removed, // Only in the old tree; new_value is invalid
+            Changed, // In both, with a different type or scalar value, or unmapped in one
+        };
+
+        Kind kind;
+        std::string path;
+        SnapshotValue old_value;
+        SnapshotValue new_value;
+    };
+
+    // Structural diff of two snapshots, taken of live trees with
+    // ValueSnapshot::capture or decoded from captures with ag_binary::decode.
+    // The values in the result point into the snapshots, so both must outlive
+    // it.
+    //
+    // Every subtree is hashed once up front; a map or list whose hash matches
+    // its counterpart is skipped without being walked. Map hashes do not
+    // depend on entry order, so the same keys in a different order compare
+    // equal. Lists are compared by position: an inserted element shows up as
+    // a change at every later index plus an addition at the end.
+    //
+    // Differences are reported depth-first, with map keys in sorted order.
+    std::vector<ValueDifference> diff(const ValueSnapshot &old_tree, const ValueSnapshot &new_tree);
+
+    // Hash of every node's subtree, indexed like snapshot.nodes()
+    std::vector<uint64_t> subtree_hashes(const ValueSnapshot &snapshot);
+}
@@ -0,0 +1,729 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "ag_binary.hpp"
+#include "snapshot.hpp"
+#include "value.hpp"
+
+namespace hydra
+{
+    // One walk over a value tree, driving an emitter chosen at compile time.
+    // Works on the game's live tree (Value *) and on snapshots alike, and
+    // emitters append straight into a caller-owned buffer, so rendering a
+    // tree allocates nothing once the buffer has grown to size.
+    //
+    // An emitter provides:
+    //   integer(int64_t), number(double), boolean(bool), string(string_view)
+    //   datetime(int64_t seconds), binary(string_view)   decoded snapshots only
+    //   unmapped(ValueType)          DateTime/Binary/Compressed nodes with no
+    //                                payload (live layouts are not mapped)
+    //   opaque(ValueType)            null and unknown nodes
+    //   begin_map(count), key(string_view), end_map()
+    //   begin_list(count), index(size_t), end_list()
+    //   needs_map_count              live maps are only counted if true
+    //   max_children                 children past this are not visited
+    template <typename Emitter>
+    void visit(Value *value, Emitter &emitter);
+
+    template <typename Emitter>
+    void visit(const SnapshotValue &value, Emitter &emitter);
+
+    namespace detail
+    {
+        inline void append_integer(std::string &out, int64_t value)
+        {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        inline void append_datetime(std::string &out, int64_t seconds)
+        {
+            auto time = std::chrono::sys_seconds(std::chrono::seconds(seconds));
+            std::format_to(std::back_inserter(out), "{:%Y-%m-%d %H:%M:%S}", time);
+        }
+    }
+
+    // The indented layout of the capture text files and the console log:
+    //   Map:
+    //     'key' => Integer: 1
+    //     'list' => List with 2 items:
+    //       [0]: String: 'a'
+    class TextEmitter
+    {
+    public:
+        static constexpr bool needs_map_count = false;
+        static constexpr size_t max_children = SIZE_MAX;
+
+        // prefix is written before the root; indent_level shifts the whole tree
+        explicit TextEmitter(std::string &out, std::string_view prefix = {}, int indent_level = 0)
+            : m_out(out), m_prefix(prefix), m_depth(indent_level)
+        {
+        }
+
+        void integer(int64_t value)
+        {
+            line_start();
+            m_out += "Integer: ";
+            detail::append_integer(m_out, value);
+            m_out += '\n';
+        }
+
+        void number(double value)
+        {
+            // Same as stream output (%g), which earlier captures were written with
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+            line_start();
+            m_out += "Double: ";
+            m_out.append(buffer, result.ptr);
+            m_out += '\n';
+        }
+
+        void boolean(bool value)
+        {
+            line_start();
+            m_out += value ? "Boolean: true\n" : "Boolean: false\n";
+        }
+
+        void string(std::string_view value)
+        {
+            line_start();
+            m_out += "String: '";
+            m_out += value;
+            m_out += "'\n";
+        }
+
+        // As ag_binary::to_text renders them
+        void datetime(int64_t seconds)
+        {
+            line_start();
+            m_out += "DateTime: ";
+            detail::append_datetime(m_out, seconds);
+            m_out += '\n';
+        }
+
+        void binary(std::string_view bytes)
+        {
+            line_start();
+            m_out += "Binary data (";
+            detail::append_integer(m_out, static_cast<int64_t>(bytes.size()));
+            m_out += " bytes)\n";
+        }
+
+        void unmapped(ValueType type)
+        {
+            opaque(type);
+        }
+
+        void opaque(ValueType type)
+        {
+            line_start();
+            switch (type)
+            {
+            case ValueType::DateTime:
+            case ValueType::HiResDateTime:
+                m_out += "DateTime: [DateTime]\n";
+                break;
+            case ValueType::Binary:
+                m_out += "Binary data\n";
+                break;
+            case ValueType::Compressed:
+                m_out += "Compressed data\n";
+                break;
+            default:
+                m_out += "Unknown type\n";
+                break;
+            }
+        }
+
+        void begin_map(size_t)
+        {
+            line_start();
+            m_out += "Map:\n";
+            ++m_depth;
+        }
+
+        void key(std::string_view key)
+        {
+            m_child = Child::Key;
+            m_key = key;
+        }
+
+        void end_map()
+        {
+            --m_depth;
+        }
+
+        void begin_list(size_t count)
+        {
+            line_start();
+            m_out += "List with ";
+            detail::append_integer(m_out, static_cast<int64_t>(count));
+            m_out += " items:\n";
+            ++m_depth;
+        }
+
+        void index(size_t index)
+        {
+            m_child = Child::Index;
+            m_index = index;
+        }
+
+        void end_list()
+        {
+            --m_depth;
+        }
+
+    private:
+        enum class Child
+        {
+            Root,
+            Key,
+            Index,
+        };
+
+        void line_start()
+        {
+            m_out.append(static_cast<size_t>(m_depth) * 2, ' ');
+            switch (m_child)
+            {
+            case Child::Root:
+                m_out += m_prefix;
+                break;
+            case Child::Key:
+                m_out += '\'';
+                m_out += m_key;
+                m_out += "' => ";
+                break;
+            case Child::Index:
+                m_out += '[';
+                detail::append_integer(m_out, static_cast<int64_t>(m_index));
+                m_out += "]: ";
+                break;
+            }
+        }
+
+        std::string &m_out;
+        std::string_view m_prefix;
+        int m_depth;
+        Child m_child = Child::Root;
+        std::string_view m_key;
+        size_t m_index = 0;
+    };
+
+    // Compact JSON, in the same shape as ag_binary::to_json: opaque nodes are
+    // null, as are non-finite doubles
+    class JsonEmitter
+    {
+    public:
+        static constexpr bool needs_map_count = false;
+        static constexpr size_t max_children = SIZE_MAX;
+
+        explicit JsonEmitter(std::string &out) : m_out(out) {}
+
+        void integer(int64_t value)
+        {
+            separate();
+            detail::append_integer(m_out, value);
+        }
+
+        void number(double value)
+        {
+            separate();
+            if (!std::isfinite(value))
+            {
+                m_out += "null";
+                return;
+            }
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            m_out.append(buffer, result.ptr);
+        }
+
+        void boolean(bool value)
+        {
+            separate();
+            m_out += value ? "true" : "false";
+        }
+
+        void string(std::string_view value)
+        {
+            separate();
+            append_string(value);
+        }
+
+        // Same as ag_binary::to_json: a date string, hex bytes
+        void datetime(int64_t seconds)
+        {
+            separate();
+            m_out += '"';
+            detail::append_datetime(m_out, seconds);
+            m_out += '"';
+        }
+
+        void binary(std::string_view bytes)
+        {
+            static constexpr char Hex[] = "0123456789abcdef";
+            separate();
+            m_out += '"';
+            for (char c : bytes)
+            {
+                m_out += Hex[static_cast<uint8_t>(c) >> 4];
+                m_out += Hex[static_cast<uint8_t>(c) & 0xF];
+            }
+            m_out += '"';
+        }
+
+        void unmapped(ValueType type)
+        {
+            opaque(type);
+        }
+
+        void opaque(ValueType)
+        {
+            separate();
+            m_out += "null";
+        }
+
+        void begin_map(size_t)
+        {
+            separate();
+            m_out += '{';
+            m_first = true;
+        }
+
+        void key(std::string_view key)
+        {
+            if (!m_first)
+            {
+                m_out += ',';
+            }
+            append_string(key);
+            m_out += ':';
+            m_after_key = true;
+        }
+
+        void end_map()
+        {
+            m_out += '}';
+            m_first = false;
+        }
+
+        void begin_list(size_t)
+        {
+            separate();
+            m_out += '[';
+            m_first = true;
+        }
+
+        void index(size_t) {}
+
+        void end_list()
+        {
+            m_out += ']';
+            m_first = false;
+        }
+
+    private:
+        // Comma before every value but the first in a container; map values
+        // follow their key directly
+        void separate()
+        {
+            if (m_after_key)
+            {
+                m_after_key = false;
+            }
+            else if (!m_first)
+            {
+                m_out += ',';
+            }
+            m_first = false;
+        }
+
+        void append_string(std::string_view text)
+        {
+            static constexpr char Hex[] = "0123456789abcdef";
+            m_out += '"';
+            for (char c : text)
+            {
+                switch (c)
+                {
+                case '"':
+                    m_out += "\\\"";
+                    break;
+                case '\\':
+                    m_out += "\\\\";
+                    break;
+                case '\n':
+                    m_out += "\\n";
+                    break;
+                case '\r':
+                    m_out += "\\r";
+                    break;
+                case '\t':
+                    m_out += "\\t";
+                    break;
+                default:
+                    if (static_cast<uint8_t>(c) < 0x20)
+                    {
+                        m_out += "\\u00";
+                        m_out += Hex[static_cast<uint8_t>(c) >> 4];
+                        m_out += Hex[static_cast<uint8_t>(c) & 0xF];
+                    }
+                    else
+                    {
+                        m_out += c;
+                    }
+                }
+            }
+            m_out += '"';
+        }
+
+        std::string &m_out;
+        bool m_first = true;
+        bool m_after_key = false;
+    };
+
+    // application/x-ag-binary; see ag_binary.hpp for the rules
+    class AgBinaryEmitter
+    {
+    public:
+        static constexpr bool needs_map_count = true;
+        static constexpr size_t MaxLongLength = UINT16_MAX; // Strings, maps and lists are clipped to this
+        static constexpr size_t max_children = MaxLongLength;
+
+        explicit AgBinaryEmitter(std::string &out) : m_out(out) {}
+
+        void integer(int64_t value)
+        {
+            using ag_binary::Type;
+            // Smallest signed form, as the reference encoders pick it
+            if (value >= INT8_MIN && value <= INT8_MAX)
+            {
+                put_type(Type::S1);
+                put_big_endian<int8_t>(static_cast<int8_t>(value));
+            }
+            else if (value >= INT16_MIN && value <= INT16_MAX)
+            {
+                put_type(Type::S2);
+                put_big_endian<int16_t>(static_cast<int16_t>(value));
+            }
+            else if (value >= INT32_MIN && value <= INT32_MAX)
+            {
+                put_type(Type::S4);
+                put_big_endian<int32_t>(static_cast<int32_t>(value));
+            }
+            else
+            {
+                put_type(Type::S8);
+                put_big_endian<int64_t>(value);
+            }
+        }
+
+        void number(double value)
+        {
+            put_type(ag_binary::Type::Double);
+            put_big_endian<uint64_t>(std::bit_cast<uint64_t>(value));
+        }
+
+        void boolean(bool value)
+        {
+            put_type(value ? ag_binary::Type::BooleanTrue : ag_binary::Type::BooleanFalse);
+        }
+
+        void string(std::string_view value)
+        {
+            if (value.size() > MaxLongLength)
+            {
+                // Back off to a code point boundary, so the clipped string is still UTF-8
+                size_t cut = MaxLongLength;
+                while (cut > 0 && (static_cast<uint8_t>(value[cut]) & 0xC0) == 0x80)
+                {
+                    --cut;
+                }
+                value = value.substr(0, cut);
+            }
+            if (value.size() <= UINT8_MAX)
+            {
+                put_type(ag_binary::Type::String);
+                put_big_endian<uint8_t>(static_cast<uint8_t>(value.size()));
+            }
+            else
+            {
+                put_type(ag_binary::Type::LongString);
+                put_big_endian<uint16_t>(static_cast<uint16_t>(value.size()));
+            }
+            m_out += value;
+        }
+
+        void datetime(int64_t seconds)
+        {
+            put_type(ag_binary::Type::DateTime);
+            put_big_endian<uint32_t>(static_cast<uint32_t>(std::clamp<int64_t>(seconds, 0, UINT32_MAX)));
+        }
+
+        void binary(std::string_view bytes)
+        {
+            using ag_binary::Type;
+            bytes = bytes.substr(0, UINT32_MAX);
+            if (bytes.size() <= UINT8_MAX)
+            {
+                put_type(Type::BinaryU1);
+                put_big_endian<uint8_t>(static_cast<uint8_t>(bytes.size()));
+            }
+            else if (bytes.size() <= UINT16_MAX)
+            {
+                put_type(Type::BinaryU2);
+                put_big_endian<uint16_t>(static_cast<uint16_t>(bytes.size()));
+            }
+            else
+            {
+                put_type(Type::BinaryU4);
+                put_big_endian<uint32_t>(static_cast<uint32_t>(bytes.size()));
+            }
+            m_out += bytes;
+        }
+
+        // Pass rather than Null, so a value we could not read stays distinct
+        // from a real null and every decoder still skips it
+        void unmapped(ValueType)
+        {
+            put_type(ag_binary::Type::Pass);
+        }
+
+        void opaque(ValueType)
+        {
+            put_type(ag_binary::Type::Null);
+        }
+
+        void begin_map(size_t count)
+        {
+            put_count(count, ag_binary::Type::Map, ag_binary::Type::LongMap);
+        }
+
+        // Map keys are string values
+        void key(std::string_view key)
+        {
+            string(key);
+        }
+
+        void end_map() {}
+
+        void begin_list(size_t count)
+        {
+            put_count(count, ag_binary::Type::Array, ag_binary::Type::LongArray);
+        }
+
+        void index(size_t) {}
+
+        void end_list() {}
+
+    private:
+        template <typename T>
+        void put_big_endian(T value)
+        {
+            using Unsigned = std::make_unsigned_t<T>;
+            Unsigned bits = static_cast<Unsigned>(value);
+            char bytes[sizeof(T)];
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                bytes[i] = static_cast<char>(bits >> (8 * (sizeof(T) - 1 - i)));
+            }
+            m_out.append(bytes, sizeof(T));
+        }
+
+        void put_type(ag_binary::Type type)
+        {
+            m_out += static_cast<char>(type);
+        }
+
+        void put_count(size_t count, ag_binary::Type short_type, ag_binary::Type long_type)
+        {
+            count = std::min(count, MaxLongLength);
+            if (count <= UINT8_MAX)
+            {
+                put_type(short_type);
+                put_big_endian<uint8_t>(static_cast<uint8_t>(count));
+            }
+            else
+            {
+                put_type(long_type);
+                put_big_endian<uint16_t>(static_cast<uint16_t>(count));
+            }
+        }
+
+        std::string &m_out;
+    };
+
+    template <typename Emitter>
+    void visit(Value *value, Emitter &emitter)
+    {
+        // Null children report 0xFF, as ValueVariant::type does
+        ValueType type = value ? ValueTypeCache::type_of(value) : static_cast<ValueType>(0xFF);
+        switch (type)
+        {
+        case ValueType::Integer:
+            emitter.integer(static_cast<IntegerValue *>(value)->value());
+            break;
+
+        case ValueType::Double:
+            emitter.number(static_cast<DoubleValue *>(value)->value);
+            break;
+
+        case ValueType::Boolean:
+            emitter.boolean(static_cast<BooleanValue *>(value)->value);
+            break;
+
+        case ValueType::String:
+            emitter.string(static_cast<StringValue *>(value)->value);
+            break;
+
+        case ValueType::Map:
+        {
+            IterableMap *map = static_cast<IterableMap *>(value);
+            size_t count = 0;
+            if constexpr (Emitter::needs_map_count)
+            {
+                for (auto it = map->begin(); it != map->end(); ++it)
+                {
+                    ++count;
+                }
+            }
+
+            emitter.begin_map(count);
+            size_t visited = 0;
+            for (auto it = map->begin(); it != map->end() && visited < Emitter::max_children; ++it, ++visited)
+            {
+                emitter.key(it.key());
+                visit(it.value().get(), emitter);
+            }
+            emitter.end_map();
+            break;
+        }
+
+        case ValueType::List:
+        {
+            ListValue *list = static_cast<ListValue *>(value);
+            emitter.begin_list(list->size());
+            size_t index = 0;
+            for (auto it = list->begin(); it != list->end() && index < Emitter::max_children; ++it, ++index)
+            {
+                emitter.index(index);
+                visit((*it).get(), emitter);
+            }
+            emitter.end_list();
+            break;
+        }
+
+        case ValueType::DateTime:
+        case ValueType::HiResDateTime:
+        case ValueType::Binary:
+        case ValueType::Compressed:
+            emitter.unmapped(type);
+            break;
+
+        default:
+            emitter.opaque(type);
+            break;
+        }
+    }
+
+    template <typename Emitter>
+    void visit(const SnapshotValue &value, Emitter &emitter)
+    {
+        if (!value.valid())
+        {
+            emitter.opaque(static_cast<ValueType>(0xFF));
+            return;
+        }
+
+        switch (value.type())
+        {
+        case ValueType::Integer:
+            emitter.integer(value.as<int64_t>());
+            break;
+
+        case ValueType::Double:
+            emitter.number(value.as<double>());
+            break;
+
+        case ValueType::Boolean:
+            emitter.boolean(value.as<bool>());
+            break;
+
+        case ValueType::String:
+            emitter.string(value.as<std::string_view>());
+            break;
+
+        case ValueType::Map:
+        {
+            emitter.begin_map(value.size());
+            size_t visited = 0;
+            for (auto it = value.begin(); it != value.end() && visited < Emitter::max_children; ++it, ++visited)
+            {
+                emitter.key(it.key());
+                visit(*it, emitter);
+            }
+            emitter.end_map();
+            break;
+        }
+
+        case ValueType::List:
+        {
+            emitter.begin_list(value.size());
+            size_t index = 0;
+            for (auto it = value.begin(); it != value.end() && index < Emitter::max_children; ++it, ++index)
+            {
+                emitter.index(index);
+                visit(*it, emitter);
+            }
+            emitter.end_list();
+            break;
+        }
+
+        case ValueType::DateTime:
+            if (value.unmapped())
+            {
+                emitter.unmapped(value.type());
+            }
+            else
+            {
+                emitter.datetime(value.datetime());
+            }
+            break;
+
+        case ValueType::Binary:
+            if (value.unmapped())
+            {
+                emitter.unmapped(value.type());
+            }
+            else
+            {
+                emitter.binary(value.bytes());
+            }
+            break;
+
+        default:
+            if (value.unmapped())
+            {
+                emitter.unmapped(value.type());
+            }
+            else
+            {
+                emitter.opaque(value.type());
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <logging/logger.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core::logging {
+
+// Identity of one LOG_* call site; registered once, referenced by id afterwards
+struct LogSite {
+    LogLevel level;
+    std::source_location loc;
+    std::string_view format;
+};
+
+namespace binary {
+
+    // Tag preceding every encoded argument
+    enum class ArgType : uint8_t {
+        Int64 = 1,
+        UInt64,
+        Double,
+        Bool,
+        Char,
+        String,  // u32 length + bytes
+        Pointer
+    };
+
+    // Framing of a record in staging buffers and .binlog files (native endian)
+    struct RecordHeader {
+        uint32_t siteId;
+        uint32_t payloadSize;
+        int64_t timestampNs; // system_clock, since epoch
+    };
+
+    // .binlog layout: FileMagic, FileVersion, then a stream of entries, each
+    // starting with an EntryTag. A site entry precedes the first record using it.
+    //   Site:   u32 id, u8 level, u32 line, u16 len + file, u16 len + format
+    //   Record: RecordHeader, payload
+    constexpr char FileMagic[4] = {'H', 'B', 'L', 'G'};
+    constexpr uint32_t FileVersion = 1;
+
+    enum class EntryTag : uint8_t {
+        Site = 'S',
+        Record = 'R'
+    };
+
+    inline void put(std::vector<uint8_t>& out, const void* data, size_t size) {
+        size_t pos = out.size();
+        out.resize(pos + size);
+        std::memcpy(out.data() + pos, data, size);
+    }
+
+    template<typename T>
+    void putTagged(std::vector<uint8_t>& out, ArgType type, T value) {
+        out.push_back(static_cast<uint8_t>(type));
+        put(out, &value, sizeof(value));
+    }
+
+    inline void putString(std::vector<uint8_t>& out, std::string_view value) {
+        out.push_back(static_cast<uint8_t>(ArgType::String));
+        uint32_t length = static_cast<uint32_t>(value.size());
+        put(out, &length, sizeof(length));
+        put(out, value.data(), value.size());
+    }
+
+    // Copies the raw value; only types without a cheap raw form are formatted here
+    template<typename T>
+    void encodeArg(std::vector<uint8_t>& out, const T& value) {
+        using D = std::remove_cvref_t<T>;
+
+        if constexpr (std::is_same_v<D, bool>) {
+            putTagged(out, ArgType::Bool, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_same_v<D, char>) {
+            putTagged(out, ArgType::Char, value);
+        } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+            putTagged(out, ArgType::Int64, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<D>) {
+            putTagged(out, ArgType::UInt64, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<D>) {
+            putTagged(out, ArgType::Double, static_cast<double>(value));
+        } else if constexpr (std::is_same_v<std::decay_t<D>, const char*> ||
+                             std::is_same_v<std::decay_t<D>, char*>) {
+            const char* text = value;
+            putString(out, text ? std::string_view(text) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            putString(out, std::string_view(value));
+        } else if constexpr (std::is_pointer_v<D>) {
+            putTagged(out, ArgType::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        } else {
+            putString(out, std::format("{}", value));
+        }
+    }
+
+    // Render a payload against its format string. Replacement fields with
+    // explicit indices and format specs are supported; nested replacement
+    // fields inside a spec are not.
+    std::string formatMessage(std::string_view format, const uint8_t* payload, size_t size);
+
+}
+
+// Single-producer/single-consumer byte ring owned by one logging thread
+class StagingBuffer {
+public:
+    explicit StagingBuffer(size_t capacity);
+
+    // False (record dropped) when there is not enough free space
+    bool push(const binary::RecordHeader& header, const uint8_t* payload);
+
+    // Consumer side: bytes published but not yet consumed
+    size_t readable() const {
+        return m_produced.load(std::memory_order_acquire) - m_consumed.load(std::memory_order_relaxed);
+    }
+
+    void copyOut(size_t offset, void* out, size_t size) const;
+    void consume(size_t size) {
+        m_consumed.store(m_consumed.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    std::vector<uint8_t>& scratch() {
+        return m_scratch;
+    }
+
+    std::atomic<bool> retired{false};
+
+private:
+    void copyIn(size_t pos, const void* data, size_t size);
+
+    const size_t m_mask;
+    std::unique_ptr<uint8_t[]> m_storage;
+    std::vector<uint8_t> m_scratch; // Producer-only encode buffer, reused per record
+
+    alignas(64) std::atomic<size_t> m_produced{0};
+    alignas(64) std::atomic<size_t> m_consumed{0};
+};
+
+struct BinaryLogOptions {
+    // Destination .binlog file. When empty, records are formatted on the
+    // background thread and forwarded to the text Logger instead.
+    std::string path;
+    size_t threadBufferSize = 1 << 20; // Staging bytes per producing thread
+    std::chrono::milliseconds pollInterval{2};
+};
+
+class BinaryLogger;
+BinaryLogger& getBinaryLogger();
+
+// Deferred-formatting backend: call sites only copy their raw arguments into a
+// per-thread staging buffer; a background thread formats or persists them
+class BinaryLogger {
+public:
+    friend BinaryLogger& getBinaryLogger();
+
+    static bool isActive() {
+        return s_active.load(std::memory_order_relaxed);
+    }
+
+    static uint32_t registerSite(const LogSite* site);
+
+    template<typename... Args>
+    void write(uint32_t siteId, const Args&... args) {
+        StagingBuffer* buffer = threadBuffer();
+        std::vector<uint8_t>& payload = buffer->scratch();
+        payload.clear();
+        (binary::encodeArg(payload, args), ...);
+
+        binary::RecordHeader header{
+            siteId,
+            static_cast<uint32_t>(payload.size()),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()};
+
+        if (!buffer->push(header, payload.data())) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false if the output file could not be opened
+    bool start(const BinaryLogOptions& options);
+
+    // Drains every staging buffer and joins the background thread
+    void stop();
+
+    // Records lost because a staging buffer was full
+    uint64_t droppedRecords() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    BinaryLogger() = default;
+    ~BinaryLogger();
+
+    StagingBuffer* threadBuffer();
+    void consumerLoop();
+    bool drain(StagingBuffer& buffer);
+    void process(const binary::RecordHeader& header, const uint8_t* payload);
+    const LogSite* lookupSite(uint32_t id);
+
+    static inline std::atomic<bool> s_active{false};
+
+    BinaryLogOptions m_options;
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<StagingBuffer>> m_buffers;
+
+    std::thread m_consumer;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Consumer-thread state
+    std::vector<const LogSite*> m_siteCache;
+    std::vector<bool> m_siteWritten;
+    std::vector<uint8_t> m_payload;
+    std::ofstream m_file;
+};
+
+}
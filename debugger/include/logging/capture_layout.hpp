@@ -0,0 +1,346 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <format>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <logging/capture_store.hpp>
+#include <logging/logger.hpp>
+#include <logging/timestamp_cache.hpp>
+
+namespace fs = std::filesystem;
+
+// The one-file-per-capture directory layout:
+//   <base>/<domain>/<path segments>/[query_<query>/]<timestamp>_<method>_request.txt
+//   <base>/<domain>/<path segments>/[query_<query>/]<timestamp>_response_<code>.txt
+// Used by RequestFileLogger's per-file output and by capture-tool to
+// materialise a segmented capture store.
+class CaptureLayout {
+public:
+    explicit CaptureLayout(const std::string& directory = "request_logs") : base_dir(directory) {}
+
+    void set_base_directory(const std::string& directory) {
+        base_dir = directory;
+        clear_path_cache();
+    }
+
+    const std::string& base_directory() const {
+        return base_dir;
+    }
+
+    // Text payloads only; the payload is written out verbatim.
+    // Returns the written file's path, or an empty string on failure
+    std::string write(const core::logging::CaptureEntry& entry) {
+        if (entry.direction == core::logging::capture::Direction::Request) {
+            return write_request_file(entry);
+        }
+        return write_response_file(entry);
+    }
+
+    // Directory a capture of this URL is written to, created on first use.
+    // Repeat lookups are served from an LRU cache without allocating or
+    // touching the filesystem.
+    const std::string& resolve_directory(std::string_view host, std::string_view endpoint, bool is_full_url) {
+        PathKey key{ host, endpoint, is_full_url };
+        auto found = path_index.find(key);
+        if (found != path_index.end()) {
+            ++path_stats.hits;
+            path_lru.splice(path_lru.begin(), path_lru, found->second);
+            return found->second->directory;
+        }
+
+        ++path_stats.misses;
+        std::string directory = create_directory_structure(parse_url(host, endpoint, is_full_url));
+        if (path_capacity == 0) {
+            uncached_directory = std::move(directory);
+            return uncached_directory;
+        }
+
+        if (path_lru.size() >= path_capacity) {
+            ++path_stats.evictions;
+            path_index.erase(path_lru.back().key());
+            path_lru.pop_back();
+        }
+
+        path_lru.push_front({ std::string(host), std::string(endpoint), is_full_url, std::move(directory) });
+        path_index.emplace(path_lru.front().key(), path_lru.begin());
+        return path_lru.front().directory;
+    }
+
+    // Entries kept by resolve_directory; 0 disables the cache. Clears it.
+    void set_path_cache_capacity(size_t capacity) {
+        path_capacity = capacity;
+        clear_path_cache();
+    }
+
+    // Call when directories may have been removed behind our back
+    void clear_path_cache() {
+        path_index.clear();
+        path_lru.clear();
+    }
+
+    struct PathCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    const PathCacheStats& path_cache_stats() const {
+        return path_stats;
+    }
+
+private:
+    std::string base_dir;
+
+    // Views into the host/endpoint strings; nothing here owns memory
+    struct UrlComponents {
+        std::string_view domain;
+        std::string_view path;
+        std::string_view query;
+    };
+
+    struct PathKey {
+        std::string_view host;
+        std::string_view endpoint;
+        bool is_full_url;
+
+        bool operator==(const PathKey&) const = default;
+    };
+
+    struct PathKeyHash {
+        size_t operator()(const PathKey& key) const {
+            size_t hash = std::hash<std::string_view>{}(key.host);
+            hash ^= std::hash<std::string_view>{}(key.endpoint) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+            return hash ^ static_cast<size_t>(key.is_full_url);
+        }
+    };
+
+    struct PathEntry {
+        std::string host;
+        std::string endpoint;
+        bool is_full_url;
+        std::string directory;
+
+        // Index keys point into the list node, which never moves
+        PathKey key() const {
+            return { host, endpoint, is_full_url };
+        }
+    };
+
+    size_t path_capacity = 1024;
+    std::list<PathEntry> path_lru; // Most recently used first
+    std::unordered_map<PathKey, std::list<PathEntry>::iterator, PathKeyHash> path_index;
+    std::string uncached_directory;
+    PathCacheStats path_stats;
+
+    UrlComponents parse_url(std::string_view host, std::string_view endpoint, bool is_full_url = false) {
+        UrlComponents result;
+        
+        if (is_full_url) {
+            size_t protocol_pos = endpoint.find("://");
+            if (protocol_pos != std::string_view::npos) {
+                size_t domain_start = protocol_pos + 3;
+                size_t path_start = endpoint.find('/', domain_start);
+                
+                if (path_start != std::string_view::npos) {
+                    result.domain = endpoint.substr(domain_start, path_start - domain_start);
+                    result.path = endpoint.substr(path_start);
+                } else {
+                    result.domain = endpoint.substr(domain_start);
+                }
+            } else {
+                // Not a URL: the whole thing is the path, query included
+                result.domain = "unknown";
+                result.path = endpoint;
+                if (!result.path.empty() && result.path[0] == '/') {
+                    result.path.remove_prefix(1);
+                }
+                return result;
+            }
+        } else {
+            result.domain = host;
+            result.path = endpoint;
+        }
+
+        size_t query_pos = result.path.find('?');
+        if (query_pos != std::string_view::npos) {
+            result.query = result.path.substr(query_pos + 1);
+            result.path = result.path.substr(0, query_pos);
+        }
+        
+        if (!result.path.empty() && result.path[0] == '/') {
+            result.path.remove_prefix(1);
+        }
+        
+        return result;
+    }
+
+    // Expects a sanitized domain, where "https://" has become "https___"
+    std::string_view normalize_domain(std::string_view domain) {
+        static constexpr std::string_view prefixes[] = {
+            "https___", "http___", "wss___", "ws___", 
+            "https_", "http_", "wss_", "ws_"
+        };
+        
+        for (std::string_view prefix : prefixes) {
+            if (domain.starts_with(prefix)) {
+                domain.remove_prefix(prefix.size());
+                break;
+            }
+        }
+        
+        return domain;
+    }
+
+    std::string create_directory_structure(const UrlComponents& url_components) {
+        std::string full_path = base_dir;
+        
+        std::string sanitized_domain = sanitize_filename(url_components.domain);
+        full_path += '/';
+        full_path += normalize_domain(sanitized_domain);
+        
+        std::string_view remaining = url_components.path;
+        while (!remaining.empty()) {
+            size_t pos = remaining.find('/');
+            std::string_view segment = remaining.substr(0, pos);
+            if (!segment.empty()) {
+                full_path += '/';
+                full_path += sanitize_filename(segment);
+            }
+            remaining = pos == std::string_view::npos ? std::string_view() : remaining.substr(pos + 1);
+        }
+        
+        if (!url_components.query.empty()) {
+            std::string query_dir = "query_" + sanitize_filename(url_components.query);
+            if (query_dir.length() > 100) {
+                query_dir = "query_" + std::to_string(std::hash<std::string_view>{}(url_components.query));
+            }
+            full_path += '/';
+            full_path += query_dir;
+        }
+        
+        // One call creates every missing level
+        ensure_directory_exists(full_path);
+        return full_path;
+    }
+    
+    std::string sanitize_filename(std::string_view filename) {
+        std::string result(filename.substr(0, 100));
+        
+        constexpr std::string_view invalid_chars = "\\/:?\"<>|*&=#%+; ";
+        for (char& c : result) {
+            if (invalid_chars.find(c) != std::string_view::npos) {
+                c = '_';
+            }
+        }
+        
+        return result;
+    }
+    
+    void ensure_directory_exists(const std::string& dir_path) {
+        std::error_code ec;
+        fs::create_directories(dir_path, ec);
+        if (ec) {
+            LOG_ERROR("Failed to create directory '{}': {}", dir_path, ec.message());
+        }
+    }
+    
+    std::string get_timestamp(std::chrono::system_clock::time_point time) {
+        // Writes may run on the writer thread or inline on hook threads; localtime
+        // only runs when the second changes
+        thread_local core::logging::TimestampCache cache("%Y%m%d_%H%M%S",
+                                                         core::logging::SubsecondPrecision::Milliseconds, '_');
+        return std::string(cache.format(time));
+    }
+
+    std::string write_request_file(const core::logging::CaptureEntry& entry) {
+        try {
+            UrlComponents url_components = parse_url(entry.host, entry.endpoint);
+            
+            const std::string& dir_path = resolve_directory(entry.host, entry.endpoint, false);
+            
+            std::string timestamp = get_timestamp(entry.time);
+            std::string filename = timestamp + "_" + entry.method + "_request.txt";
+            std::string filepath = dir_path + "/" + filename;
+            
+            std::ofstream file(filepath);
+            if (!file.is_open()) {
+                // The cached directory may have been deleted since it was created
+                clear_path_cache();
+                LOG_ERROR("Failed to open file for writing: {}", filepath);
+                return {};
+            }
+            
+            file << "Host: " << entry.host << "\n";
+            file << "Endpoint: " << entry.endpoint << "\n";
+            file << "Method: " << entry.method << "\n";
+            file << "Timestamp: " << timestamp << "\n";
+            
+            if (!url_components.query.empty()) {
+                file << "Query Parameters: " << url_components.query << "\n";
+            }
+            
+            file << "\n";
+            
+            if (entry.payloadFormat != core::logging::capture::PayloadFormat::None) {
+                file << "Request Data:\n";
+                file << entry.payload;
+            } else {
+                file << "No request data\n";
+            }
+            
+            file.close();
+            LOG_INFO("Request saved to file: {}", filepath);
+            return filepath;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error saving request to file: {}", e.what());
+            return {};
+        }
+    }
+    
+    std::string write_response_file(const core::logging::CaptureEntry& entry) {
+        try {
+            UrlComponents url_components = parse_url("", entry.endpoint, true);
+            
+            const std::string& dir_path = resolve_directory("", entry.endpoint, true);
+            
+            std::string timestamp = get_timestamp(entry.time);
+            std::string filename = timestamp + "_response_" + 
+                                  std::to_string(entry.responseCode) + ".txt";
+            std::string filepath = dir_path + "/" + filename;
+            
+            std::ofstream file(filepath);
+            if (!file.is_open()) {
+                // The cached directory may have been deleted since it was created
+                clear_path_cache();
+                LOG_ERROR("Failed to open file for writing: {}", filepath);
+                return {};
+            }
+            
+            file << "Full URL: " << entry.endpoint << "\n";
+            file << "Response Code: " << entry.responseCode << "\n";
+            file << "Timestamp: " << timestamp << "\n";
+            
+            if (!url_components.query.empty()) {
+                file << "Query Parameters: " << url_components.query << "\n";
+            }
+            
+            file << "\n";
+            
+            if (entry.payloadFormat != core::logging::capture::PayloadFormat::None) {
+                file << "Response Data:\n";
+                file << entry.payload;
+            } else {
+                file << "No response data\n";
+            }
+            
+            file.close();
+            LOG_INFO("Response saved to file: {}", filepath);
+            return filepath;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error saving response to file: {}", e.what());
+            return {};
+        }
+    }
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core::logging {
+
+// Append-only segmented capture store.
+//
+// A segment is a file holding a short header followed by length-prefixed
+// records. Records are only ever appended, and only whole records reach the
+// disk, so a segment cut short by a crash loses at most its last record.
+// Segments are named segment_NNNNNN.hcap; a new one is started once the
+// current one would grow past CaptureStoreOptions::segmentBytes.
+//
+//   segment := FileMagic u32(version) record*
+//   record  := u32(size) RecordHeader host endpoint method payload
+//
+// A compressed payload is u32(uncompressed length) followed by the
+// compressed bytes. With FlagDictionary set, the previous payload of the
+// same endpoint in the same segment was the preset dictionary; segments
+// never depend on each other, so retention can delete whole segments.
+namespace capture {
+    constexpr char FileMagic[4] = { 'H', 'C', 'A', 'P' };
+    constexpr uint32_t FileVersion = 1;
+    constexpr const char* SegmentExtension = ".hcap";
+
+    enum class Direction : uint8_t {
+        Request = 0,
+        Response = 1,
+    };
+
+    enum class Compression : uint8_t {
+        None = 0,
+        Zlib = 1,
+        Zstd = 2, // Only when built with CAPTURE_ZSTD
+    };
+
+    // RecordHeader::flags
+    constexpr uint8_t FlagDictionary = 0x01;
+
+    enum class PayloadFormat : uint8_t {
+        None = 0,     // No data was attached
+        Text = 1,     // Value tree rendered as text
+        AgBinary = 2, // Value tree in application/x-ag-binary (see hydra/ag_binary.hpp)
+    };
+
+    struct RecordHeader {
+        int64_t timestampNs;    // system_clock, since the epoch
+        uint32_t payloadLength;
+        int32_t responseCode;
+        uint32_t hostLength;
+        uint32_t endpointLength;
+        uint32_t methodLength;
+        uint8_t direction;
+        uint8_t payloadFormat;
+        uint8_t compression;
+        uint8_t flags;
+    };
+    static_assert(sizeof(RecordHeader) == 32, "RecordHeader is written to disk as-is");
+}
+
+struct CaptureEntry {
+    capture::Direction direction = capture::Direction::Request;
+    std::chrono::system_clock::time_point time;
+    std::string host;
+    std::string endpoint;
+    std::string method;
+    int32_t responseCode = 0;
+    capture::PayloadFormat payloadFormat = capture::PayloadFormat::None;
+    std::string payload;
+};
+
+struct CaptureStoreOptions {
+    uint64_t segmentBytes = 64ull * 1024 * 1024; // Start a new segment past this size
+    size_t bufferBytes = 256 * 1024;             // Records are written out in batches of about this size
+
+    capture::Compression compression = capture::Compression::None;
+    int compressionLevel = 6;
+
+    // Checked whenever a segment is started; the oldest segments are deleted
+    // until both hold. 0 disables either limit.
+    uint64_t retentionBytes = 0;
+    std::chrono::seconds retentionAge{0};
+};
+
+// Per-record payload compressor/decompressor, defined in capture_store.cpp
+class CaptureCodec;
+
+// Last payload seen per endpoint, used as the next record's dictionary
+class CaptureDictionaries {
+public:
+    std::string_view find(const CaptureEntry& entry) const;
+    void update(const CaptureEntry& entry, std::string_view payload);
+    void clear() {
+        m_dictionaries.clear();
+    }
+
+private:
+    std::unordered_map<std::string, std::string> m_dictionaries;
+    mutable std::string m_key;
+};
+
+// Not thread-safe; owned by whoever writes the captures
+class CaptureStoreWriter {
+public:
+    explicit CaptureStoreWriter(std::string directory, const CaptureStoreOptions& options = {});
+    ~CaptureStoreWriter();
+
+    CaptureStoreWriter(const CaptureStoreWriter&) = delete;
+    CaptureStoreWriter& operator=(const CaptureStoreWriter&) = delete;
+
+    // Compresses the payload as configured; call from a background thread
+    bool append(const CaptureEntry& entry);
+
+    // Write out buffered records
+    void flush();
+
+    uint64_t payloadBytes() const {
+        return m_payloadBytes;
+    }
+
+    // Payload bytes after compression
+    uint64_t storedPayloadBytes() const {
+        return m_storedPayloadBytes;
+    }
+
+    const std::string& segmentPath() const {
+        return m_segmentPath;
+    }
+
+private:
+    bool openSegment();
+    void closeSegment();
+    void applyRetention();
+
+    std::string m_directory;
+    CaptureStoreOptions m_options;
+    std::unique_ptr<CaptureCodec> m_codec;
+    CaptureDictionaries m_dictionaries;
+    std::string m_compressed;
+    uint64_t m_payloadBytes = 0;
+    uint64_t m_storedPayloadBytes = 0;
+    std::ofstream m_file;
+    std::string m_segmentPath;
+    uint32_t m_sequence = 0;
+    uint64_t m_segmentSize = 0; // Including buffered bytes
+    std::string m_buffer;
+};
+
+// Segment paths in a store directory, oldest first
+std::vector<std::string> listCaptureSegments(const std::string& directory);
+
+class CaptureSegmentReader {
+public:
+    explicit CaptureSegmentReader(const std::string& path);
+    ~CaptureSegmentReader();
+
+    // False if the file is missing or not a capture segment
+    bool isValid() const {
+        return m_valid;
+    }
+
+    // False at the end of the segment, at a record cut off mid-write, or at a
+    // payload that cannot be decompressed. Payloads are returned decompressed.
+    bool next(CaptureEntry& entry);
+
+    // Set once next() hit a partial record
+    bool truncated() const {
+        return m_truncated;
+    }
+
+    // Set once next() hit a payload it could not decompress
+    bool corrupt() const {
+        return m_corrupt;
+    }
+
+private:
+    std::ifstream m_file;
+    std::unique_ptr<CaptureCodec> m_codec;
+    CaptureDictionaries m_dictionaries;
+    std::string m_compressed;
+    bool m_valid = false;
+    bool m_truncated = false;
+    bool m_corrupt = false;
+};
+
+}
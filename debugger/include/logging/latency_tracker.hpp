@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace core::logging {
+
+// Log-bucketed histogram in the style of HdrHistogram: every power of two is
+// split into SubBuckets linear buckets, so any recorded value is reported
+// within 1/SubBuckets (about 3%) of its true value. The unit is the caller's:
+// LatencyTracker records microseconds, the hook overhead monitor and the
+// replay harness nanoseconds.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SubBucketBits = 5;
+    static constexpr uint64_t SubBuckets = 1ull << SubBucketBits;
+    static constexpr uint64_t MaxValue = (1ull << 40) - 1; // ~12.7 days; larger values are clamped
+    static constexpr size_t BucketCount = (40 - SubBucketBits + 1) * SubBuckets;
+
+    // The bucket layout, for recorders that keep their own counts (e.g.
+    // atomics written by one thread) and fold them in with addToBucket()
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketHighest(size_t index);
+
+    void record(uint64_t value);
+
+    // count samples of bucket index, each taken as the bucket's highest value
+    void addToBucket(size_t index, uint64_t count);
+
+    // Adds other's samples, e.g. to combine per-thread histograms
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const {
+        return m_count;
+    }
+
+    uint64_t min() const {
+        return m_count ? m_min : 0;
+    }
+
+    uint64_t max() const {
+        return m_max;
+    }
+
+    double mean() const {
+        return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0;
+    }
+
+    // Highest value equivalent to the one at quantile q (0..1)
+    uint64_t percentile(double q) const;
+
+private:
+    std::array<uint64_t, BucketCount> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+};
+
+// Pairs outgoing hydra requests with their responses and keeps per-endpoint
+// round-trip latency and response-code counts.
+//
+// Requests are matched per (client, endpoint path) in FIFO order; the path
+// excludes scheme, host and query so the relative endpoint seen when the
+// request is made matches the full URL seen on the response.
+class LatencyTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Requests still unanswered after this are dropped and counted as expired
+    explicit LatencyTracker(std::chrono::seconds timeout = std::chrono::seconds(300));
+
+    void onRequest(const void* client, std::string_view endpoint, Clock::time_point time = Clock::now());
+    void onResponse(const void* client, std::string_view url, int32_t responseCode, Clock::time_point time = Clock::now());
+
+    // Writes p50/p99/p999, counts and response codes per endpoint. The file
+    // is replaced atomically so readers never see a partial report.
+    bool writeReport(const std::string& path) const;
+    std::string report() const;
+
+    void reset();
+
+    // "https://host/a/b?x=1", "/a/b?x=1" and "a/b" all become "a/b"
+    static std::string_view endpointPath(std::string_view endpointOrUrl);
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    struct EndpointStats {
+        LatencyHistogram latency;
+        std::map<int32_t, uint64_t> responseCodes;
+        uint64_t unmatched = 0; // Responses with no pending request
+        uint64_t expired = 0;   // Requests that timed out waiting
+        std::unordered_map<const void*, std::deque<Clock::time_point>> pending;
+    };
+
+    EndpointStats& endpoint(std::string_view path);
+
+    std::chrono::seconds m_timeout;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, EndpointStats, StringHash, std::equal_to<>> m_endpoints;
+    Clock::time_point m_started;
+};
+
+}
@@ -5,6 +5,14 @@
 #include <string_view>
 #include <concepts>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <logging/timestamp_cache.hpp>
 
 namespace core::logging {
 
@@ -17,6 +25,37 @@ enum class LogLevel {
     Fatal   
 };
 
+// What a producer does when the async queue is full
+enum class OverflowPolicy {
+    Block,      // Spin until the consumer frees a slot
+    DropNewest, // Discard the record being logged
+    DropOldest  // Discard the oldest queued record to make room
+};
+
+struct AsyncOptions {
+    size_t capacity = 8192; // Rounded up to a power of two; fixed by the first start
+    OverflowPolicy overflow = OverflowPolicy::DropNewest;
+};
+
+// A pre-formatted record; rendering (timestamp, color) happens when it is written
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::source_location loc;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+};
+
+template<typename T>
+class MpscRingBuffer;
+
+class Sink;
+
+// Fixed-width level tag ("INFO ", "WARN ", ...) used in rendered lines
+std::string_view getLevelString(LogLevel level);
+
+// Strips the directory part of a source path
+std::string_view getFileName(std::string_view path);
+
 class Logger;
 Logger& getLogger();
 
@@ -29,12 +68,7 @@ public:
              const std::source_location& loc,
              std::format_string<Args...> fmt,
              Args&&... args) {
-        std::string message = std::format(fmt, std::forward<Args>(args)...);
-        
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        
-        logImpl(level, message, loc);
+        logImpl(level, std::format(fmt, std::forward<Args>(args)...), loc);
     }
 
     void log(LogLevel level,
@@ -43,21 +77,115 @@ public:
         logImpl(level, std::string(msg), loc);
     }
 
+    // Write an already formatted record (used by the binary log decoder)
+    void submit(LogRecord&& record);
+
+    // Records below the runtime floor are rejected by the LOG_* macros before
+    // any argument is evaluated. The floor is the higher of the configured
+    // minimum level and the lowest sink threshold.
+    static bool isEnabled(LogLevel level) {
+        return static_cast<int>(level) >= s_levelFloor.load(std::memory_order_relaxed);
+    }
+
+    static void setMinLevel(LogLevel level);
+
+    static LogLevel minLevel() {
+        return static_cast<LogLevel>(s_levelFloor.load(std::memory_order_relaxed));
+    }
+
+    // Outputs; each applies its own threshold. A colored console sink is
+    // installed by default.
+    void addSink(std::shared_ptr<Sink> sink);
+    void removeSink(const std::shared_ptr<Sink>& sink);
+    void clearSinks();
+
+    // Emit whatever the sinks have batched so far
+    void flush();
+
+    // Hand records to a dedicated consumer thread through a bounded lock-free
+    // queue, so callers never block on console output (unless the overflow
+    // policy is Block and the queue is full). Call before hooks are installed.
+    void startAsync(const AsyncOptions& options = {});
+
+    // Drain outstanding records and join the consumer thread. Must be called
+    // before the module unloads; records logged afterwards are written inline.
+    void stopAsync();
+
+    bool isAsync() const {
+        return m_async.load(std::memory_order_acquire);
+    }
+
+    // Records discarded by the DropNewest/DropOldest overflow policies
+    uint64_t droppedRecords() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
 private:
-    Logger() = default;
+    Logger();
+    ~Logger();
     
     void logImpl(LogLevel level, 
-                 const std::string& message,
+                 std::string&& message,
                  const std::source_location& loc);
+
+    void enqueue(LogRecord&& record);
+    void writeRecord(const LogRecord& record);
+    void consumerLoop();
+    void wakeConsumer();
+    void updateLevelFloor();
+
+    static inline std::atomic<int> s_levelFloor{0};
+
+    std::unique_ptr<MpscRingBuffer<LogRecord>> m_queue;
+    std::thread m_consumer;
+    std::mutex m_writeMutex;
+    std::mutex m_controlMutex;
+    std::vector<std::shared_ptr<Sink>> m_sinks;
+    std::string m_line;
+    TimestampCache m_timestamps;
+    std::atomic<LogLevel> m_minLevel{LogLevel::Trace};
+    OverflowPolicy m_overflow = OverflowPolicy::DropNewest;
+
+    std::atomic<bool> m_async{false};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_consumerIdle{false};
+    std::atomic<uint32_t> m_wakeups{0};
+    std::atomic<uint64_t> m_dropped{0};
 };
 
 }
 
+#include <logging/binary_log.hpp>
+
+// Compile-time floor as the integer value of a LogLevel (0 = Trace ... 5 = Fatal).
+// Calls below it compile to nothing.
+#ifndef LOG_COMPILE_MIN_LEVEL
+    #define LOG_COMPILE_MIN_LEVEL 0
+#endif
+
+// True when a record at this level would be emitted; use it to guard work done
+// only to produce log output
+#define LOG_ENABLED(level) \
+    (static_cast<int>(level) >= LOG_COMPILE_MIN_LEVEL && ::core::logging::Logger::isEnabled(level))
+
 // Logging macros with cross-compiler compatibility
 #ifdef ENABLE_LOGGING
-    // Helper macro to handle the empty __VA_ARGS__ case
+    // Helper macro to handle the empty __VA_ARGS__ case. Both level checks run
+    // before the arguments are evaluated; the compile-time one folds away.
+    // In binary mode the call site registers itself once and only copies its
+    // raw arguments; the format string is still checked by the text branch.
     #define LOG_INTERNAL(level, fmt, ...) \
-        ::core::logging::getLogger().log(level, std::source_location::current(), fmt, ##__VA_ARGS__)
+        do { \
+            if (LOG_ENABLED(level)) { \
+                if (::core::logging::BinaryLogger::isActive()) { \
+                    static const ::core::logging::LogSite logSite{level, std::source_location::current(), fmt}; \
+                    static const uint32_t logSiteId = ::core::logging::BinaryLogger::registerSite(&logSite); \
+                    ::core::logging::getBinaryLogger().write(logSiteId, ##__VA_ARGS__); \
+                } else { \
+                    ::core::logging::getLogger().log(level, std::source_location::current(), fmt, ##__VA_ARGS__); \
+                } \
+            } \
+        } while (0)
 
     #define LOG_TRACE(fmt, ...) LOG_INTERNAL(::core::logging::LogLevel::Trace, fmt, ##__VA_ARGS__)
     #define LOG_DEBUG(fmt, ...) LOG_INTERNAL(::core::logging::LogLevel::Debug, fmt, ##__VA_ARGS__)
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <logging/latency_tracker.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::logging {
+
+// Time the hooks add to the game's request path, by phase, and the console
+// verbosity that keeps it within a budget.
+//
+// Each hook thread records into its own histograms: plain relaxed atomic
+// bucket counts with a single writer, so recording takes no lock and no
+// read-modify-write (only a thread's first record registers it). evaluate(),
+// called about once a second, folds what was recorded since its previous call
+// into a rolling window of Options::windowIntervals calls. While the window's
+// p99 of Total is over budget, verbosity steps down (Full, Summary, Counters);
+// once it is under half the budget it steps back up. After each step the
+// window is left to refill before the next one. Every step is logged.
+class OverheadMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase : uint8_t {
+        Print,    // Console output: log lines and tree printing
+        Snapshot, // Copying the value tree for capture
+        Capture,  // Handing the capture to the writer thread
+        Total,    // The whole callback, excluding the game's own function
+    };
+    static constexpr size_t PhaseCount = 4;
+
+    enum class Verbosity : uint8_t {
+        Full,     // Every tree printed
+        Summary,  // One line per call
+        Counters, // Nothing per call; LatencyTracker and countSuppressed() keep counts
+    };
+
+    struct Options {
+        std::chrono::microseconds budget{1000}; // For the p99 of Total
+        size_t windowIntervals = 10;            // evaluate() calls in the rolling window
+        uint64_t minSamples = 20;               // Fewer calls in the window decide nothing
+    };
+
+    OverheadMonitor();
+    explicit OverheadMonitor(const Options& options);
+    ~OverheadMonitor();
+
+    OverheadMonitor(const OverheadMonitor&) = delete;
+    OverheadMonitor& operator=(const OverheadMonitor&) = delete;
+
+    void setOptions(const Options& options);
+
+    void record(Phase phase, Clock::duration elapsed);
+
+    Verbosity verbosity() const {
+        return m_verbosity.load(std::memory_order_relaxed);
+    }
+
+    // A call whose output was left out at Counters
+    void countSuppressed() {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Folds new samples into the window without adapting; evaluate() does both
+    void collect();
+    void evaluate();
+
+    // p50/p99/max per phase over the window
+    std::string report() const;
+
+    static std::string_view phaseName(Phase phase);
+    static std::string_view verbosityName(Verbosity verbosity);
+
+    // Records the time a scope takes; does nothing for a null monitor
+    class Timer {
+    public:
+        Timer(OverheadMonitor* monitor, Phase phase)
+            : m_monitor(monitor), m_phase(phase), m_start(monitor ? Clock::now() : Clock::time_point()) {}
+
+        ~Timer() {
+            if (m_monitor) {
+                m_monitor->record(m_phase, Clock::now() - m_start);
+            }
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        OverheadMonitor* m_monitor;
+        Phase m_phase;
+        Clock::time_point m_start;
+    };
+
+private:
+    struct ThreadHistograms;
+    using Interval = std::array<LatencyHistogram, PhaseCount>;
+
+    ThreadHistograms& local();
+    void collectLocked();
+    LatencyHistogram windowed(Phase phase) const;
+
+    const uint64_t m_id; // Tells this monitor's thread-local slot from a previous one's
+    std::atomic<Verbosity> m_verbosity{Verbosity::Full};
+    std::atomic<uint64_t> m_suppressed{0};
+
+    mutable std::mutex m_mutex;
+    Options m_options;
+    std::vector<std::unique_ptr<ThreadHistograms>> m_threads;
+    std::deque<std::unique_ptr<Interval>> m_window;
+    size_t m_holdOff = 0; // evaluate() calls left before the next step
+};
+
+}
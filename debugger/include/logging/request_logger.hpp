@@ -1,355 +1,371 @@
 #pragma once
-#include <filesystem>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
-#include <format>
-#include <regex>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <logging/capture_layout.hpp>
+#include <logging/capture_store.hpp>
+#include <logging/overhead_monitor.hpp>
+#include <logging/ring_buffer.hpp>
+#include <hydra/ag_binary.hpp>
+#include <hydra/snapshot.hpp>
 #include <hydra/value.hpp>
+#include <hydra/value_visitor.hpp>
 #include <hydra/request.hpp>
 #include <hydra/client.hpp>
 
-namespace fs = std::filesystem;
 using namespace hydra;
 
+enum class CaptureOutput {
+    Store, // Segmented append-only store under the base directory
+    Files, // One text file per capture in a directory tree
+};
+
+enum class CapturePayload {
+    Text,     // Indented text, as in the per-file captures
+    AgBinary, // application/x-ag-binary; Store output only, Files output always uses text
+};
+
+struct CaptureOptions {
+    CaptureOutput output = CaptureOutput::Store;
+    CapturePayload payload = CapturePayload::Text;
+    uint64_t segment_bytes = 64ull * 1024 * 1024;   // Store output: start a new segment past this size
+    core::logging::capture::Compression compression = core::logging::capture::Compression::None; // Store output
+    uint64_t retention_bytes = 0;                   // Store output: delete the oldest segments past this total; 0 = keep
+    std::chrono::seconds retention_age{0};          // Store output: delete segments older than this; 0 = keep
+    size_t max_queued_records = 4096;               // Rounded up to a power of two; fixed by the first start
+    size_t max_queued_bytes = 256ull * 1024 * 1024; // Snapshot bytes held by the queue
+};
+
+struct CaptureStats {
+    uint64_t enqueued = 0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;         // Queue full or over the byte budget
+    uint64_t queued_bytes = 0;
+    uint64_t peak_queued_bytes = 0;
+    uint64_t path_cache_hits = 0;   // Files output: directory lookups served from the cache
+    uint64_t path_cache_misses = 0;
+};
+
 class RequestFileLogger {
 private:
-    bool enabled = false;
-    std::string base_dir;
-    
-    struct UrlComponents {
-        std::string domain;
-        std::string path;
-        std::string query;
+    // Everything the writer thread needs, copied out of the game's objects
+    struct CaptureRecord {
+        enum class Direction { Request, Response };
+
+        Direction direction = Direction::Request;
+        std::chrono::system_clock::time_point time;
+        std::string host;
+        std::string endpoint;
+        std::string method;
+        int32_t response_code = 0;
+        ValueSnapshot data;
+
+        size_t byte_size() const {
+            return sizeof(CaptureRecord) + host.capacity() + endpoint.capacity() + method.capacity() + data.byte_size();
+        }
     };
+
+    bool enabled = false;
+    CaptureLayout layout;
+    std::unique_ptr<core::logging::CaptureStoreWriter> store;
+    mutable std::mutex output_mutex; // Writer thread vs. inline writes before start / during unload
+    core::logging::CaptureEntry scratch; // Reused per record so its buffers keep their capacity
+
+    CaptureOptions options;
+    std::unique_ptr<core::logging::MpscRingBuffer<CaptureRecord>> queue;
+    std::thread writer;
+    std::atomic<bool> running{false};
+    std::atomic<bool> accepting{false};
+    std::atomic<bool> writer_idle{false};
+    std::atomic<bool> writer_exited{false}; // Set by the writer once it has drained and returned
+    std::atomic<bool> stopped{false};       // Set by stop(): records are dropped until the next start()
+    std::atomic<uint32_t> wakeups{0};
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> queued_bytes{0};
+    std::atomic<uint64_t> peak_queued_bytes{0};
+    core::logging::OverheadMonitor* overhead = nullptr; // Times the snapshot and enqueue when set
     
-    UrlComponents parse_url(const std::string& host, const std::string& endpoint, bool is_full_url = false) {
-        UrlComponents result;
-        
-        if (is_full_url) {
-            size_t protocol_pos = endpoint.find("://");
-            if (protocol_pos != std::string::npos) {
-                size_t domain_start = protocol_pos + 3;
-                size_t path_start = endpoint.find('/', domain_start);
-                
-                if (path_start != std::string::npos) {
-                    result.domain = sanitize_filename(endpoint.substr(domain_start, path_start - domain_start));
-                    std::string path_part = endpoint.substr(path_start);
-                    
-                    size_t query_pos = path_part.find('?');
-                    if (query_pos != std::string::npos) {
-                        result.path = path_part.substr(0, query_pos);
-                        result.query = path_part.substr(query_pos + 1);
-                    } else {
-                        result.path = path_part;
-                        result.query = "";
-                    }
-                } else {
-                    result.domain = sanitize_filename(endpoint.substr(domain_start));
-                    result.path = "";
-                    result.query = "";
-                }
+    // Indented text layout of the capture files, rendered from an owned snapshot
+    void snapshot_to_string(const ValueSnapshot& snapshot, std::string& out) {
+        TextEmitter emitter(out);
+        visit(snapshot.root(), emitter);
+    }
+
+    // Caller holds output_mutex
+    void write_entry(const CaptureRecord& record) {
+        core::logging::CaptureEntry& entry = scratch;
+        entry.direction = record.direction == CaptureRecord::Direction::Request
+                              ? core::logging::capture::Direction::Request
+                              : core::logging::capture::Direction::Response;
+        entry.time = record.time;
+        entry.host.assign(record.host);
+        entry.endpoint.assign(record.endpoint);
+        entry.method.assign(record.method);
+        entry.responseCode = record.response_code;
+        entry.payloadFormat = core::logging::capture::PayloadFormat::None;
+        entry.payload.clear();
+
+        if (!record.data.empty()) {
+            if (options.output == CaptureOutput::Store && options.payload == CapturePayload::AgBinary) {
+                ag_binary::encode(record.data, entry.payload);
+                entry.payloadFormat = core::logging::capture::PayloadFormat::AgBinary;
             } else {
-                result.domain = "unknown";
-                result.path = endpoint;
-                result.query = "";
+                snapshot_to_string(record.data, entry.payload);
+                entry.payloadFormat = core::logging::capture::PayloadFormat::Text;
+            }
+        }
+
+        if (options.output == CaptureOutput::Store) {
+            if (!store) {
+                core::logging::CaptureStoreOptions store_options;
+                store_options.segmentBytes = options.segment_bytes;
+                store_options.compression = options.compression;
+                store_options.retentionBytes = options.retention_bytes;
+                store_options.retentionAge = options.retention_age;
+                store = std::make_unique<core::logging::CaptureStoreWriter>(layout.base_directory(), store_options);
             }
+            store->append(entry);
         } else {
-            result.domain = sanitize_filename(host);
-            
-            size_t query_pos = endpoint.find('?');
-            if (query_pos != std::string::npos) {
-                result.path = endpoint.substr(0, query_pos);
-                result.query = endpoint.substr(query_pos + 1);
+            layout.write(entry);
+        }
+    }
+
+    void write_record(const CaptureRecord& record) {
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (stopped.load(std::memory_order_relaxed)) {
+                // A hook that got past the accepting check just before stop():
+                // drop the record rather than open a store nothing would close
+                dropped.fetch_add(1, std::memory_order_relaxed);
             } else {
-                result.path = endpoint;
-                result.query = "";
+                write_entry(record);
             }
         }
-        
-        if (!result.path.empty() && result.path[0] == '/') {
-            result.path = result.path.substr(1);
-        }
-        
-        return result;
+        completed.fetch_add(1, std::memory_order_release);
     }
 
-    std::string normalize_domain(const std::string& domain) {
-        std::string result = domain;
-        
-        const std::vector<std::string> prefixes = {
-            "https___", "http___", "wss___", "ws___", 
-            "https_", "http_", "wss_", "ws_"
-        };
-        
-        for (const auto& prefix : prefixes) {
-            if (result.size() >= prefix.size() && result.substr(0, prefix.size()) == prefix) {
-                result = result.substr(prefix.size());
-                break;
-            }
+    void flush_output() {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        if (store) {
+            store->flush();
         }
-        
-        return result;
     }
 
-    
-    std::string create_directory_structure(const UrlComponents& url_components) {
-        std::string full_path = base_dir;
-        
-        std::string normalized_domain = normalize_domain(url_components.domain);
-        full_path += "/" + normalized_domain;
-        ensure_directory_exists(full_path);
-        
-        std::string path_copy = url_components.path;
-        std::vector<std::string> segments;
-        
-        size_t pos = 0;
-        while ((pos = path_copy.find('/')) != std::string::npos) {
-            std::string segment = path_copy.substr(0, pos);
-            if (!segment.empty()) {
-                segments.push_back(sanitize_filename(segment));
-            }
-            path_copy.erase(0, pos + 1);
+    void submit(CaptureRecord&& record) {
+        enqueued.fetch_add(1, std::memory_order_relaxed);
+
+        if (!accepting.load(std::memory_order_acquire)) {
+            // Pipeline not started: keep the original synchronous behaviour
+            write_record(record);
+            return;
         }
-        
-        if (!path_copy.empty()) {
-            segments.push_back(sanitize_filename(path_copy));
+
+        // Reserve the bytes before the push, so concurrent hooks cannot overshoot
+        // the budget between them and the writer never subtracts bytes not yet added
+        size_t bytes = record.byte_size();
+        uint64_t now_queued = queued_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        if (now_queued > options.max_queued_bytes || !queue->tryPush(std::move(record))) {
+            queued_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            completed.fetch_add(1, std::memory_order_release);
+            return;
         }
-        
-        for (const auto& segment : segments) {
-            full_path += "/" + segment;
-            ensure_directory_exists(full_path);
+
+        uint64_t peak = peak_queued_bytes.load(std::memory_order_relaxed);
+        while (now_queued > peak &&
+               !peak_queued_bytes.compare_exchange_weak(peak, now_queued, std::memory_order_relaxed)) {
         }
-        
-        if (!url_components.query.empty()) {
-            std::string query_dir = "query_" + sanitize_filename(url_components.query);
-            if (query_dir.length() > 100) {
-                query_dir = "query_" + std::to_string(std::hash<std::string>{}(url_components.query));
-            }
-            full_path += "/" + query_dir;
-            ensure_directory_exists(full_path);
+
+        // Same handshake as the async logger: either the writer sees the record
+        // on its re-check or we see it idle and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer_idle.load(std::memory_order_relaxed)) {
+            wake_writer();
         }
-        
-        return full_path;
     }
-    
-    std::string sanitize_filename(const std::string& filename) {
-        std::string result = filename;
-        
-        const std::string invalid_chars = "\\/:?\"<>|*&=#%+; ";
-        for (char& c : result) {
-            if (invalid_chars.find(c) != std::string::npos) {
-                c = '_';
-            }
-        }
-        
-        if (result.length() > 100) {
-            result = result.substr(0, 100);
-        }
-        
-        return result;
+
+    void wake_writer() {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
     }
-    
-    void ensure_directory_exists(const std::string& dir_path) {
-        if (!fs::exists(dir_path)) {
-            try {
-                fs::create_directories(dir_path);
-            } catch (const std::exception& e) {
-                LOG_ERROR("Failed to create directory '{}': {}", dir_path, e.what());
-            }
+
+    // Pops and writes one queued record; false when the queue is empty
+    bool write_next() {
+        CaptureRecord record;
+        if (!queue->tryPop(record)) {
+            return false;
         }
+        queued_bytes.fetch_sub(record.byte_size(), std::memory_order_relaxed);
+        write_record(record);
+        return true;
     }
-    
-    std::string get_timestamp() {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-            
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%Y%m%d_%H%M%S_") 
-           << std::setfill('0') << std::setw(3) << ms.count();
-        return ss.str();
-    }
-    
-    void value_to_string(const ValueVariant& value, std::stringstream& ss, 
-                          const std::string& prefix = "", int indent_level = 0) {
-        std::string indent(indent_level * 2, ' ');
-
-        switch (value.type()) {
-        case ValueType::Integer:
-            ss << indent << prefix << "Integer: " << value.as<int64_t>() << "\n";
-            break;
-
-        case ValueType::Double:
-            ss << indent << prefix << "Double: " << value.as<double>() << "\n";
-            break;
 
-        case ValueType::Boolean:
-            ss << indent << prefix << "Boolean: " << (value.as<bool>() ? "true" : "false") << "\n";
-            break;
-
-        case ValueType::String:
-            ss << indent << prefix << "String: '" << value.as<std::string>() << "'\n";
-            break;
-
-        case ValueType::Map:
-        {
-            ss << indent << prefix << "Map:\n";
-            MapValue* mapValue = static_cast<MapValue*>(value.get());
-            if (mapValue) {
-                IterableMap* iterableMap = static_cast<IterableMap*>(mapValue);
-                if (iterableMap) {
-                    for (auto it = iterableMap->begin(); it != iterableMap->end(); ++it) {
-                        auto [key, subValue] = *it;
-                        value_to_string(subValue, ss, std::format("'{}' => ", key), indent_level + 1);
-                    }
-                }
+    void writer_loop() {
+        for (;;) {
+            while (write_next()) {
             }
-            break;
-        }
+            // Hand the batch to the OS before going idle
+            flush_output();
 
-        case ValueType::List:
-        {
-            ListValue* listValue = static_cast<ListValue*>(value.get());
-            ss << indent << prefix << "List with " << listValue->size() << " items:\n";
+            if (!running.load(std::memory_order_acquire)) {
+                writer_exited.store(true, std::memory_order_release);
+                return;
+            }
 
-            int index = 0;
-            for (auto it = listValue->begin(); it != listValue->end(); ++it, ++index) {
-                value_to_string(*it, ss, std::format("[{}]: ", index), indent_level + 1);
+            uint32_t ticket = wakeups.load(std::memory_order_acquire);
+            writer_idle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue->empty() && running.load(std::memory_order_acquire)) {
+                wakeups.wait(ticket, std::memory_order_acquire);
             }
-            break;
+            writer_idle.store(false, std::memory_order_relaxed);
         }
+    }
 
-        case ValueType::DateTime:
-        case ValueType::HiResDateTime:
-            ss << indent << prefix << "DateTime: " << value.to_string() << "\n";
-            break;
 
-        case ValueType::Binary:
-            ss << indent << prefix << "Binary data\n";
-            break;
 
-        case ValueType::Compressed:
-            ss << indent << prefix << "Compressed data\n";
-            break;
+public:
+    RequestFileLogger(const std::string& directory = "request_logs") : layout(directory) {}
 
-        default:
-            ss << indent << prefix << "Unknown type\n";
-            break;
-        }
+    // The DLL calls stop() from MainThread before it unloads; this covers
+    // every other owner
+    ~RequestFileLogger() {
+        stop();
     }
-
-public:
-    RequestFileLogger(const std::string& directory = "request_logs") : base_dir(directory) {}
     
     void enable_logging(bool enable) {
         enabled = enable;
     }
     
+    // Takes effect for the store on the next start()
     void set_base_directory(const std::string& directory) {
-        base_dir = directory;
+        std::lock_guard<std::mutex> lock(output_mutex);
+        layout.set_base_directory(directory);
     }
     
     bool is_enabled() const {
         return enabled;
     }
+
+    // Set before the hooks are enabled; nullptr stops the timing
+    void set_overhead_monitor(core::logging::OverheadMonitor* monitor) {
+        overhead = monitor;
+    }
+
+    // Move path building, serialization and file I/O to a writer thread. The
+    // hooks then only snapshot the value tree and enqueue it.
+    void start(const CaptureOptions& capture_options = {}) {
+        if (running.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            options = capture_options;
+            store.reset();
+            stopped.store(false, std::memory_order_relaxed);
+        }
+        if (!queue) {
+            queue = std::make_unique<core::logging::MpscRingBuffer<CaptureRecord>>(options.max_queued_records);
+        }
+
+        writer_exited.store(false, std::memory_order_relaxed);
+        running.store(true, std::memory_order_release);
+        writer = std::thread(&RequestFileLogger::writer_loop, this);
+        accepting.store(true, std::memory_order_release);
+    }
+
+    // Join the writer thread, then write what it left queued. Only the writer
+    // drains the queue until it has been joined; nothing is written from two
+    // threads at once. Records submitted afterwards are dropped until the next
+    // start(). Not for DllMain: joining under the loader lock can deadlock.
+    void stop() {
+        accepting.store(false, std::memory_order_release);
+        if (!running.exchange(false, std::memory_order_acq_rel)) {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            stopped.store(true, std::memory_order_relaxed);
+            store.reset();
+            return;
+        }
+
+        wake_writer();
+        if (writer.joinable()) {
+            writer.join();
+        }
+
+        // A writer that never got to return was terminated with the process
+        // (the destructor at exit) and may have died holding output_mutex
+        if (!writer_exited.load(std::memory_order_acquire)) {
+            stopped.store(true, std::memory_order_relaxed);
+            return;
+        }
+        while (write_next()) {
+        }
+
+        std::lock_guard<std::mutex> lock(output_mutex);
+        stopped.store(true, std::memory_order_relaxed);
+        store.reset();
+    }
+
+    // Block until every record submitted before this call has been written or dropped
+    void flush() {
+        uint64_t target = enqueued.load(std::memory_order_acquire);
+        while (completed.load(std::memory_order_acquire) < target && running.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    CaptureStats stats() const {
+        CaptureStats result;
+        result.enqueued = enqueued.load(std::memory_order_relaxed);
+        result.written = completed.load(std::memory_order_relaxed) - dropped.load(std::memory_order_relaxed);
+        result.dropped = dropped.load(std::memory_order_relaxed);
+        result.queued_bytes = queued_bytes.load(std::memory_order_relaxed);
+        result.peak_queued_bytes = peak_queued_bytes.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(output_mutex);
+        result.path_cache_hits = layout.path_cache_stats().hits;
+        result.path_cache_misses = layout.path_cache_stats().misses;
+        return result;
+    }
     
     void save_request(hydra::Client* client, const std::string& endpoint, const std::string& method, 
                        hydra::Value* data) {
         if (!enabled || !client) return;
-        
-        try {
-            ensure_directory_exists(base_dir);
-            
-            std::string host = client->host_address;
-            
-            UrlComponents url_components = parse_url(host, endpoint);
-            
-            std::string dir_path = create_directory_structure(url_components);
-            
-            std::string filename = get_timestamp() + "_" + method + "_request.txt";
-            std::string filepath = dir_path + "/" + filename;
-            
-            std::ofstream file(filepath);
-            if (!file.is_open()) {
-                LOG_ERROR("Failed to open file for writing: {}", filepath);
-                return;
-            }
-            
-            file << "Host: " << host << "\n";
-            file << "Endpoint: " << endpoint << "\n";
-            file << "Method: " << method << "\n";
-            file << "Timestamp: " << get_timestamp() << "\n";
-            
-            if (!url_components.query.empty()) {
-                file << "Query Parameters: " << url_components.query << "\n";
-            }
-            
-            file << "\n";
-            
-            if (data) {
-                file << "Request Data:\n";
-                std::stringstream ss;
-                ValueVariant value_var(data);
-                value_to_string(value_var, ss);
-                file << ss.str();
-            } else {
-                file << "No request data\n";
-            }
-            
-            file.close();
-            LOG_INFO("Request saved to file: {}", filepath);
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error saving request to file: {}", e.what());
+
+        CaptureRecord record;
+        record.direction = CaptureRecord::Direction::Request;
+        record.time = std::chrono::system_clock::now();
+        record.host = client->host_address();
+        record.endpoint = endpoint;
+        record.method = method;
+        if (data) {
+            core::logging::OverheadMonitor::Timer timer(overhead, core::logging::OverheadMonitor::Phase::Snapshot);
+            record.data = ValueSnapshot::capture(ValueVariant(data));
         }
+
+        core::logging::OverheadMonitor::Timer timer(overhead, core::logging::OverheadMonitor::Phase::Capture);
+        submit(std::move(record));
     }
     
     void save_response(hydra::Client* client, const hydra::Request* request) {
         if (!enabled || !request) return;
-        
-        try {
-            ensure_directory_exists(base_dir);
-            
-            UrlComponents url_components = parse_url("", request->endpoint, true);
-            
-            std::string dir_path = create_directory_structure(url_components);
-            
-            std::string filename = get_timestamp() + "_response_" + 
-                                  std::to_string(request->response_code) + ".txt";
-            std::string filepath = dir_path + "/" + filename;
-            
-            std::ofstream file(filepath);
-            if (!file.is_open()) {
-                LOG_ERROR("Failed to open file for writing: {}", filepath);
-                return;
-            }
-            
-            file << "Full URL: " << request->endpoint << "\n";
-            file << "Response Code: " << request->response_code << "\n";
-            file << "Timestamp: " << get_timestamp() << "\n";
-            
-            if (!url_components.query.empty()) {
-                file << "Query Parameters: " << url_components.query << "\n";
-            }
-            
-            file << "\n";
-            
-            if (request->data) {
-                file << "Response Data:\n";
-                std::stringstream ss;
-                ValueVariant data = request->get_data();
-                value_to_string(data, ss);
-                file << ss.str();
-            } else {
-                file << "No response data\n";
-            }
-            
-            file.close();
-            LOG_INFO("Response saved to file: {}", filepath);
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error saving response to file: {}", e.what());
+
+        CaptureRecord record;
+        record.direction = CaptureRecord::Direction::Response;
+        record.time = std::chrono::system_clock::now();
+        record.endpoint = request->endpoint();
+        record.response_code = request->response_code();
+        if (request->data()) {
+            core::logging::OverheadMonitor::Timer timer(overhead, core::logging::OverheadMonitor::Phase::Snapshot);
+            record.data = ValueSnapshot::capture(request->get_data());
         }
+
+        core::logging::OverheadMonitor::Timer timer(overhead, core::logging::OverheadMonitor::Phase::Capture);
+        submit(std::move(record));
     }
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace core::logging {
+
+// Bounded lock-free queue (Vyukov's sequence-numbered ring).
+//
+// Any number of producers may push concurrently. Pops are normally performed by
+// the single logger consumer thread, but the algorithm is safe for concurrent
+// pops as well, which is what the drop-oldest overflow policy relies on: a
+// producer that finds the ring full pops (and discards) the oldest record itself.
+template<typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(size_t capacity)
+        : m_mask(roundUpToPowerOfTwo(capacity) - 1),
+          m_cells(std::make_unique<Cell[]>(m_mask + 1)) {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpscRingBuffer() {
+        T discarded;
+        while (tryPop(discarded)) {
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    // Returns false (leaving value untouched) when the ring is full
+    bool tryPush(T&& value) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false when the ring is empty
+    bool tryPop(T& out) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        T* stored = std::launder(reinterpret_cast<T*>(cell->storage));
+        out = std::move(*stored);
+        stored->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate; only meaningful as a hint while producers are active
+    bool empty() const {
+        return m_enqueuePos.load(std::memory_order_acquire) ==
+               m_dequeuePos.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(CacheLine) std::atomic<size_t> m_enqueuePos{0};
+    alignas(CacheLine) std::atomic<size_t> m_dequeuePos{0};
+};
+
+}
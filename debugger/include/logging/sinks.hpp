@@ -0,0 +1,138 @@
+#pragma once
+
+#include <logging/logger.hpp>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::logging {
+
+// Destination for rendered log lines. The Logger renders every record once
+// and hands the same line to each sink whose threshold accepts it; sinks
+// batch lines and emit them when flush() is called at the end of a batch.
+class Sink {
+public:
+    explicit Sink(LogLevel threshold) : m_threshold(threshold) {}
+    virtual ~Sink() = default;
+
+    LogLevel threshold() const {
+        return m_threshold;
+    }
+
+    bool accepts(LogLevel level) const {
+        return level >= m_threshold;
+    }
+
+    // Queue one rendered line (no color codes, no trailing newline)
+    virtual void append(LogLevel level, std::string_view line) = 0;
+
+    // Emit everything queued since the last flush
+    virtual void flush() = 0;
+
+private:
+    const LogLevel m_threshold;
+};
+
+// Accumulates lines in one buffer and emits a whole batch with a single write
+// call. A batch is also emitted early once it grows past batchBytes.
+class BufferedSink : public Sink {
+public:
+    BufferedSink(LogLevel threshold, size_t batchBytes);
+
+    void flush() override;
+
+protected:
+    void appendLine(std::string_view prefix, std::string_view line, std::string_view suffix);
+
+    // Write the whole batch; returns false if the destination is unavailable
+    virtual bool writeBatch(std::string_view data) = 0;
+
+private:
+    std::string m_batch;
+    size_t m_batchBytes;
+};
+
+// Standard output with ANSI level colors
+class ConsoleSink : public BufferedSink {
+public:
+    explicit ConsoleSink(LogLevel threshold = LogLevel::Trace, bool colors = true,
+                         size_t batchBytes = 64 * 1024);
+
+    void append(LogLevel level, std::string_view line) override;
+
+protected:
+    bool writeBatch(std::string_view data) override;
+
+private:
+    bool m_colors;
+};
+
+// Plain text file, opened for appending
+class FileSink : public BufferedSink {
+public:
+    FileSink(std::string path, LogLevel threshold = LogLevel::Trace, size_t batchBytes = 256 * 1024);
+    ~FileSink() override;
+
+    void append(LogLevel level, std::string_view line) override;
+
+    bool isOpen() const {
+        return m_handle != InvalidHandle;
+    }
+
+protected:
+    bool writeBatch(std::string_view data) override;
+
+    bool openFile(bool truncate);
+    void closeFile();
+
+    static constexpr intptr_t InvalidHandle = -1;
+
+    std::string m_path;
+    intptr_t m_handle = InvalidHandle; // HANDLE on Windows, file descriptor elsewhere
+    uint64_t m_fileSize = 0;
+};
+
+struct RotationOptions {
+    uint64_t maxBytes = 64ull * 1024 * 1024; // Rotate when the file would grow past this
+    std::chrono::seconds maxAge{0};           // Rotate files older than this; 0 disables
+    size_t maxFiles = 5;                      // Rotated files kept as path.1 ... path.N
+};
+
+// File sink that rolls over by size and/or age, keeping a bounded history
+class RotatingFileSink : public FileSink {
+public:
+    RotatingFileSink(std::string path, const RotationOptions& rotation,
+                     LogLevel threshold = LogLevel::Trace, size_t batchBytes = 256 * 1024);
+
+protected:
+    bool writeBatch(std::string_view data) override;
+
+private:
+    void rotate();
+
+    RotationOptions m_rotation;
+    std::chrono::steady_clock::time_point m_openedAt;
+};
+
+// Keeps the most recent lines in memory, e.g. for dumping after a crash
+class RingSink : public Sink {
+public:
+    explicit RingSink(size_t capacity, LogLevel threshold = LogLevel::Trace);
+
+    void append(LogLevel level, std::string_view line) override;
+    void flush() override {}
+
+    // Oldest first
+    std::vector<std::string> lines() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_lines;
+    size_t m_next = 0;
+    bool m_wrapped = false;
+};
+
+}
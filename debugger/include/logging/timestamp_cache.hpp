@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace core::logging {
+
+enum class SubsecondPrecision {
+    None,
+    Milliseconds,
+    Microseconds
+};
+
+// Renders wall-clock timestamps with strftime, but only calls localtime when
+// the second changes; the sub-second suffix is appended arithmetically.
+// Not thread-safe: keep one per thread or use it under the owner's lock.
+class TimestampCache {
+public:
+    explicit TimestampCache(std::string pattern = "%H:%M:%S",
+                            SubsecondPrecision precision = SubsecondPrecision::None,
+                            char separator = '.');
+
+    // The returned view stays valid until the next call
+    std::string_view format(std::chrono::system_clock::time_point time);
+
+    std::string_view now() {
+        return format(std::chrono::system_clock::now());
+    }
+
+private:
+    std::string m_pattern;
+    SubsecondPrecision m_precision;
+    char m_separator;
+
+    int64_t m_cachedSecond = INT64_MIN;
+    size_t m_secondsLength = 0;
+    char m_buffer[64] = {};
+};
+
+}
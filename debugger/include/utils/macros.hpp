@@ -1,6 +1,6 @@
 #pragma once
-#include <windows.h>
 #include <cstdint>
+#include <type_traits>
 
 #define STR_MERGE_IMPL(a, b) a##b
 #define STR_MERGE(a, b) STR_MERGE_IMPL(a, b)
@@ -10,25 +10,38 @@
 #define CONCAT_1(arg1, arg2) CONCAT_2(arg1, arg2)
 #define MAKE_PAD(size) char CONCAT_1(pad_, __COUNTER__)[size]
 
-#define PROPERTY(type, name) __declspec(property(get = property_get_##name, put = property_put_##name)) type name
-#define PROPERTY_GET(type, name) inline type property_get_##name() const
-#define PROPERTY_PUT(type, name) inline void property_put_##name(type val)
-
+namespace utils
+{
+    // The field of type T at offset bytes into a game object
+    template <typename T>
+    inline T &field_at(const void *object, uintptr_t offset)
+    {
+        return *reinterpret_cast<T *>(reinterpret_cast<uintptr_t>(object) + offset);
+    }
+}
 
-#define SET_MEMBER_OFFSET(type, name, offset)                                         \
-    PROPERTY(type, name);                                                             \
-    PROPERTY_GET(type, name)                                                          \
-    {                                                                                 \
-        return *reinterpret_cast<type *>(reinterpret_cast<uintptr_t>(this) + offset); \
-    }                                                                                 \
-    PROPERTY_PUT(type, name)                                                          \
-    {                                                                                 \
-        *reinterpret_cast<type *>(reinterpret_cast<uintptr_t>(this) + offset) = val;  \
+// Fields of game objects we only ever see through a pointer. Each becomes an
+// inline accessor, name(), returning a reference to the field, and a
+// name_offset constant; both compile down to a load at a fixed offset.
+#define SET_MEMBER_OFFSET(type, name, offset)                                    \
+    static constexpr uintptr_t name##_offset = offset;                           \
+    type &name()                                                                 \
+    {                                                                            \
+        return ::utils::field_at<type>(this, offset);                            \
+    }                                                                            \
+    const std::add_const_t<type> &name() const                                   \
+    {                                                                            \
+        return ::utils::field_at<std::add_const_t<type>>(this, offset);          \
     }
 
-#define SET_MEMBER_OFFSET_REFERENCE(type, name, offset) \
-    PROPERTY(type *, name);                            \
-    PROPERTY_GET(type *, name)                         \
-    {                                                  \
-        return reinterpret_cast<type *>(reinterpret_cast<uintptr_t>(this) + offset); \
+// As above for a field used in place: name() returns its address
+#define SET_MEMBER_OFFSET_REFERENCE(type, name, offset)                          \
+    static constexpr uintptr_t name##_offset = offset;                           \
+    type *name()                                                                 \
+    {                                                                            \
+        return &::utils::field_at<type>(this, offset);                           \
+    }                                                                            \
+    const type *name() const                                                     \
+    {                                                                            \
+        return &::utils::field_at<const type>(this, offset);                     \
     }
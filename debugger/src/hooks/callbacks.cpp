@@ -0,0 +1,120 @@
+#include <hooks/callbacks.hpp>
+#include <logging/logger.hpp>
+#include <cstdio>
+
+using core::logging::OverheadMonitor;
+
+RequestFileLogger g_file_logger;
+core::logging::LatencyTracker g_latency;
+OverheadMonitor g_overhead;
+std::atomic<uint32_t> g_callbacks_in_flight{0};
+
+void *original_request_response_fn = nullptr;
+void *original_make_request_fn = nullptr;
+
+namespace
+{
+    // Counts a callback in g_callbacks_in_flight until it returns to the game
+    struct InFlight
+    {
+        InFlight()
+        {
+            g_callbacks_in_flight.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        ~InFlight()
+        {
+            g_callbacks_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        InFlight(const InFlight &) = delete;
+        InFlight &operator=(const InFlight &) = delete;
+    };
+
+    void print_response(hydra::Request **request_ref, OverheadMonitor::Verbosity verbosity)
+    {
+        hydra::Request *request = request_ref ? *request_ref : nullptr;
+        if (verbosity == OverheadMonitor::Verbosity::Summary)
+        {
+            if (request)
+                LOG_INFO("Response: {} ({})", request->endpoint(), request->response_code());
+            else
+                LOG_INFO("Invalid request reference");
+            return;
+        }
+
+        LOG_INFO("Response: 0x{:X}", (uintptr_t)request_ref);
+        if (request)
+        {
+            // Log request information with clean formatting
+            hydra::ValueUtils::log_request_data(request);
+        }
+        else
+        {
+            LOG_INFO("Invalid request reference");
+        }
+        printf("\n\n");
+    }
+}
+
+void *callback_request_response(hydra::Client *client, void *unk, hydra::Request **request_ref)
+{
+    InFlight in_flight;
+    {
+        /* Everything up to the call into the game counts as hook overhead */
+        OverheadMonitor::Timer total(&g_overhead, OverheadMonitor::Phase::Total);
+        OverheadMonitor::Verbosity verbosity = g_overhead.verbosity();
+        hydra::Request *request = request_ref ? *request_ref : nullptr;
+
+        if (request)
+        {
+            /* Timestamp before any logging so it isn't counted as latency */
+            g_latency.onResponse(client, request->endpoint(), request->response_code());
+        }
+
+        if (verbosity == OverheadMonitor::Verbosity::Counters)
+        {
+            g_overhead.countSuppressed();
+        }
+        else
+        {
+            OverheadMonitor::Timer print(&g_overhead, OverheadMonitor::Phase::Print);
+            print_response(request_ref, verbosity);
+        }
+
+        if (request && g_file_logger.is_enabled()) {
+            g_file_logger.save_response(client, request);
+        }
+    }
+    return ((request_response_fn_t)original_request_response_fn)(client, unk, request_ref);
+}
+
+void *callback_make_request(hydra::Client *client, std::string &endpoint, std::string &method, hydra::MapValue *data, void *a5, void *a6, void *callback)
+{
+    InFlight in_flight;
+    {
+        OverheadMonitor::Timer total(&g_overhead, OverheadMonitor::Phase::Total);
+        OverheadMonitor::Verbosity verbosity = g_overhead.verbosity();
+
+        g_latency.onRequest(client, endpoint);
+
+        if (verbosity == OverheadMonitor::Verbosity::Counters)
+        {
+            g_overhead.countSuppressed();
+        }
+        else
+        {
+            OverheadMonitor::Timer print(&g_overhead, OverheadMonitor::Phase::Print);
+            LOG_INFO("Making {} request to {}", method, endpoint);
+            if (verbosity == OverheadMonitor::Verbosity::Full)
+            {
+                hydra::ValueUtils::print_value( data );
+            }
+        }
+
+        if (g_file_logger.is_enabled()) {
+            g_file_logger.save_request(client, endpoint, method, data);
+        }
+    }
+    return ((make_request_fn_t)original_make_request_fn)(client, endpoint, method, data, a5, a6, callback);
+}
@@ -0,0 +1,12 @@
+#include <hydra/ag_binary.hpp>
+#include <hydra/value_visitor.hpp>
+
+namespace hydra::ag_binary
+{
+    void encode(const ValueSnapshot &snapshot, std::string &out)
+    {
+        // An empty snapshot has no valid root and is written as Null
+        AgBinaryEmitter emitter(out);
+        visit(snapshot.root(), emitter);
+    }
+}
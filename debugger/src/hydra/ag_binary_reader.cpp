@@ -0,0 +1,706 @@
+#include <hydra/ag_binary.hpp>
+#include <hydra/snapshot.hpp>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <sstream>
+#include <vector>
+#include <zlib.h>
+
+namespace hydra::ag_binary
+{
+    namespace
+    {
+        // Deeper nesting than this is treated as malformed input
+        constexpr int MaxDepth = 256;
+
+        // Compressed bodies inflating past this are treated as malformed input
+        constexpr size_t MaxInflatedBytes = 64 * 1024 * 1024;
+
+        class Reader
+        {
+        public:
+            explicit Reader(std::string_view data) : m_data(data) {}
+
+            template <typename T>
+            bool read(T &out)
+            {
+                if (m_data.size() - m_pos < sizeof(T))
+                {
+                    return false;
+                }
+                std::make_unsigned_t<T> bits = 0;
+                for (size_t i = 0; i < sizeof(T); ++i)
+                {
+                    bits = static_cast<std::make_unsigned_t<T>>((bits << 8) | static_cast<uint8_t>(m_data[m_pos++]));
+                }
+                out = static_cast<T>(bits);
+                return true;
+            }
+
+            bool take(size_t size, std::string_view &out)
+            {
+                if (m_data.size() - m_pos < size)
+                {
+                    return false;
+                }
+                out = m_data.substr(m_pos, size);
+                m_pos += size;
+                return true;
+            }
+
+            // Length-prefixed string or binary body for the given type
+            bool read_bytes(Type type, std::string_view &out)
+            {
+                uint8_t u1;
+                uint16_t u2;
+                uint32_t u4;
+                switch (type)
+                {
+                case Type::String:
+                case Type::BinaryU1:
+                    return read(u1) && take(u1, out);
+                case Type::LongString:
+                case Type::BinaryU2:
+                    return read(u2) && take(u2, out);
+                case Type::BinaryU4:
+                    return read(u4) && take(u4, out);
+                default:
+                    return false;
+                }
+            }
+
+            bool read_count(Type type, uint32_t &count)
+            {
+                uint8_t u1;
+                uint16_t u2;
+                if (type == Type::Array || type == Type::Map)
+                {
+                    if (!read(u1))
+                        return false;
+                    count = u1;
+                    return true;
+                }
+                if (!read(u2))
+                    return false;
+                count = u2;
+                return true;
+            }
+
+        private:
+            std::string_view m_data;
+            size_t m_pos = 0;
+        };
+
+        // A scalar, already decoded; containers are walked by the renderers
+        struct Scalar
+        {
+            enum class Kind
+            {
+                Null,
+                Pass, // What the encoder writes for a value it could not read
+                Boolean,
+                Signed,
+                Unsigned,
+                Number,
+                String,
+                Binary,
+                DateTime,
+                Compressed,
+            };
+
+            Kind kind = Kind::Null;
+            bool boolean = false;
+            int64_t integer = 0;
+            uint64_t unsigned_integer = 0;
+            double number = 0.0;
+            std::string_view bytes;
+        };
+
+        bool is_container(Type type)
+        {
+            return type == Type::Array || type == Type::LongArray || type == Type::Map || type == Type::LongMap;
+        }
+
+        bool read_scalar(Reader &reader, Type type, Scalar &out)
+        {
+            using Kind = Scalar::Kind;
+            switch (type)
+            {
+            case Type::Pass:
+                out.kind = Kind::Pass;
+                return true;
+            case Type::Null:
+                out.kind = Kind::Null;
+                return true;
+            case Type::BooleanFalse:
+            case Type::BooleanTrue:
+                out.kind = Kind::Boolean;
+                out.boolean = type == Type::BooleanTrue;
+                return true;
+            case Type::S1:
+            {
+                int8_t value;
+                out.kind = Kind::Signed;
+                return reader.read(value) && (out.integer = value, true);
+            }
+            case Type::S2:
+            {
+                int16_t value;
+                out.kind = Kind::Signed;
+                return reader.read(value) && (out.integer = value, true);
+            }
+            case Type::S4:
+            {
+                int32_t value;
+                out.kind = Kind::Signed;
+                return reader.read(value) && (out.integer = value, true);
+            }
+            case Type::S8:
+                out.kind = Kind::Signed;
+                return reader.read(out.integer);
+            case Type::U1:
+            {
+                uint8_t value;
+                out.kind = Kind::Unsigned;
+                return reader.read(value) && (out.unsigned_integer = value, true);
+            }
+            case Type::U2:
+            {
+                uint16_t value;
+                out.kind = Kind::Unsigned;
+                return reader.read(value) && (out.unsigned_integer = value, true);
+            }
+            case Type::U4:
+            {
+                uint32_t value;
+                out.kind = Kind::Unsigned;
+                return reader.read(value) && (out.unsigned_integer = value, true);
+            }
+            case Type::U8:
+                out.kind = Kind::Unsigned;
+                return reader.read(out.unsigned_integer);
+            case Type::Float:
+            {
+                uint32_t bits;
+                out.kind = Kind::Number;
+                return reader.read(bits) && (out.number = std::bit_cast<float>(bits), true);
+            }
+            case Type::Double:
+            {
+                uint64_t bits;
+                out.kind = Kind::Number;
+                return reader.read(bits) && (out.number = std::bit_cast<double>(bits), true);
+            }
+            case Type::String:
+            case Type::LongString:
+                out.kind = Kind::String;
+                return reader.read_bytes(type, out.bytes);
+            case Type::BinaryU1:
+            case Type::BinaryU2:
+            case Type::BinaryU4:
+                out.kind = Kind::Binary;
+                return reader.read_bytes(type, out.bytes);
+            case Type::DateTime:
+            {
+                uint32_t seconds;
+                out.kind = Kind::DateTime;
+                return reader.read(seconds) && (out.unsigned_integer = seconds, true);
+            }
+            case Type::Compressed:
+            {
+                uint8_t marker, inner;
+                out.kind = Kind::Compressed;
+                return reader.read(marker) && reader.read(inner) &&
+                       reader.read_bytes(static_cast<Type>(inner), out.bytes);
+            }
+            default:
+                return false;
+            }
+        }
+
+        // Body of a Compressed value: a zlib stream holding another encoded value
+        bool inflate_body(std::string_view compressed, std::string &out)
+        {
+            z_stream stream{};
+            if (inflateInit(&stream) != Z_OK)
+            {
+                return false;
+            }
+
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+            stream.avail_in = static_cast<uInt>(compressed.size());
+
+            int result = Z_OK;
+            size_t written = 0;
+            out.resize(std::max<size_t>(compressed.size() * 4, 256));
+            while (result == Z_OK)
+            {
+                if (written == out.size())
+                {
+                    if (out.size() >= MaxInflatedBytes)
+                    {
+                        break;
+                    }
+                    out.resize(out.size() * 2);
+                }
+                stream.next_out = reinterpret_cast<Bytef *>(out.data() + written);
+                stream.avail_out = static_cast<uInt>(out.size() - written);
+                result = inflate(&stream, Z_NO_FLUSH);
+                written = out.size() - stream.avail_out;
+            }
+            inflateEnd(&stream);
+
+            out.resize(written);
+            return result == Z_STREAM_END;
+        }
+
+        std::string format_datetime(uint64_t seconds)
+        {
+            auto time = std::chrono::sys_seconds(std::chrono::seconds(seconds));
+            return std::format("{:%Y-%m-%d %H:%M:%S}", time);
+        }
+
+        // depth counts containers and compressed wrappers; indent_level only containers
+        bool render_text(Reader &reader, std::string &out, const std::string &prefix, int indent_level, int depth)
+        {
+            uint8_t type_byte;
+            if (depth > MaxDepth || !reader.read(type_byte))
+            {
+                return false;
+            }
+            Type type = static_cast<Type>(type_byte);
+            std::string indent(indent_level * 2, ' ');
+
+            if (is_container(type))
+            {
+                uint32_t count;
+                if (!reader.read_count(type, count))
+                {
+                    return false;
+                }
+
+                bool is_map = type == Type::Map || type == Type::LongMap;
+                if (is_map)
+                {
+                    out += std::format("{}{}Map:\n", indent, prefix);
+                }
+                else
+                {
+                    out += std::format("{}{}List with {} items:\n", indent, prefix, count);
+                }
+
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    std::string child_prefix;
+                    if (is_map)
+                    {
+                        // Keys are written as values; the reference decoders accept strings and integers
+                        uint8_t key_type;
+                        Scalar key;
+                        if (!reader.read(key_type) || !read_scalar(reader, static_cast<Type>(key_type), key))
+                        {
+                            return false;
+                        }
+                        if (key.kind == Scalar::Kind::Signed)
+                            child_prefix = std::format("'{}' => ", key.integer);
+                        else if (key.kind == Scalar::Kind::Unsigned)
+                            child_prefix = std::format("'{}' => ", key.unsigned_integer);
+                        else
+                            child_prefix = std::format("'{}' => ", key.bytes);
+                    }
+                    else
+                    {
+                        child_prefix = std::format("[{}]: ", i);
+                    }
+
+                    if (!render_text(reader, out, child_prefix, indent_level + 1, depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            Scalar value;
+            if (!read_scalar(reader, type, value))
+            {
+                return false;
+            }
+
+            out += indent;
+            out += prefix;
+            switch (value.kind)
+            {
+            case Scalar::Kind::Null:
+                out += "Null\n";
+                break;
+            case Scalar::Kind::Pass:
+                out += "Pass\n";
+                break;
+            case Scalar::Kind::Boolean:
+                out += value.boolean ? "Boolean: true\n" : "Boolean: false\n";
+                break;
+            case Scalar::Kind::Signed:
+                out += std::format("Integer: {}\n", value.integer);
+                break;
+            case Scalar::Kind::Unsigned:
+                out += std::format("Integer: {}\n", value.unsigned_integer);
+                break;
+            case Scalar::Kind::Number:
+            {
+                // Stream formatting, to match what the live capture path writes
+                std::ostringstream ss;
+                ss << value.number;
+                out += std::format("Double: {}\n", ss.str());
+                break;
+            }
+            case Scalar::Kind::String:
+                out += std::format("String: '{}'\n", value.bytes);
+                break;
+            case Scalar::Kind::Binary:
+                out += std::format("Binary data ({} bytes)\n", value.bytes.size());
+                break;
+            case Scalar::Kind::DateTime:
+                out += std::format("DateTime: {}\n", format_datetime(value.unsigned_integer));
+                break;
+            case Scalar::Kind::Compressed:
+            {
+                // Rendered in place of the wrapper, as the reference decoders do
+                std::string inflated;
+                if (!inflate_body(value.bytes, inflated))
+                {
+                    out += std::format("Compressed data ({} bytes)\n", value.bytes.size());
+                    return false;
+                }
+                out.resize(out.size() - indent.size() - prefix.size());
+                Reader inner(inflated);
+                return render_text(inner, out, prefix, indent_level, depth + 1);
+            }
+            }
+            return true;
+        }
+
+        void append_json_string(std::string &out, std::string_view text)
+        {
+            out.push_back('"');
+            for (char c : text)
+            {
+                switch (c)
+                {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                default:
+                    if (static_cast<uint8_t>(c) < 0x20)
+                    {
+                        out += std::format("\\u{:04x}", static_cast<uint8_t>(c));
+                    }
+                    else
+                    {
+                        out.push_back(c);
+                    }
+                }
+            }
+            out.push_back('"');
+        }
+
+        void append_hex(std::string &out, std::string_view bytes)
+        {
+            out.push_back('"');
+            for (char c : bytes)
+            {
+                out += std::format("{:02x}", static_cast<uint8_t>(c));
+            }
+            out.push_back('"');
+        }
+
+        bool render_json(Reader &reader, std::string &out, int depth)
+        {
+            uint8_t type_byte;
+            if (depth > MaxDepth || !reader.read(type_byte))
+            {
+                return false;
+            }
+            Type type = static_cast<Type>(type_byte);
+
+            if (is_container(type))
+            {
+                uint32_t count;
+                if (!reader.read_count(type, count))
+                {
+                    return false;
+                }
+
+                bool is_map = type == Type::Map || type == Type::LongMap;
+                out.push_back(is_map ? '{' : '[');
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    if (i > 0)
+                    {
+                        out.push_back(',');
+                    }
+                    if (is_map)
+                    {
+                        uint8_t key_type;
+                        Scalar key;
+                        if (!reader.read(key_type) || !read_scalar(reader, static_cast<Type>(key_type), key))
+                        {
+                            return false;
+                        }
+                        if (key.kind == Scalar::Kind::Signed)
+                            out += std::format("\"{}\"", key.integer);
+                        else if (key.kind == Scalar::Kind::Unsigned)
+                            out += std::format("\"{}\"", key.unsigned_integer);
+                        else
+                            append_json_string(out, key.bytes);
+                        out.push_back(':');
+                    }
+                    if (!render_json(reader, out, depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                out.push_back(is_map ? '}' : ']');
+                return true;
+            }
+
+            Scalar value;
+            if (!read_scalar(reader, type, value))
+            {
+                return false;
+            }
+
+            switch (value.kind)
+            {
+            case Scalar::Kind::Null:
+            case Scalar::Kind::Pass:
+                out += "null";
+                break;
+            case Scalar::Kind::Boolean:
+                out += value.boolean ? "true" : "false";
+                break;
+            case Scalar::Kind::Signed:
+                out += std::format("{}", value.integer);
+                break;
+            case Scalar::Kind::Unsigned:
+                out += std::format("{}", value.unsigned_integer);
+                break;
+            case Scalar::Kind::Number:
+                // JSON has no NaN or infinity
+                out += std::isfinite(value.number) ? std::format("{}", value.number) : "null";
+                break;
+            case Scalar::Kind::String:
+                append_json_string(out, value.bytes);
+                break;
+            case Scalar::Kind::Binary:
+                append_hex(out, value.bytes);
+                break;
+            case Scalar::Kind::Compressed:
+            {
+                std::string inflated;
+                if (!inflate_body(value.bytes, inflated))
+                {
+                    return false;
+                }
+                Reader inner(inflated);
+                return render_json(inner, out, depth + 1);
+            }
+            case Scalar::Kind::DateTime:
+                append_json_string(out, format_datetime(value.unsigned_integer));
+                break;
+            }
+            return true;
+        }
+    }
+
+    namespace
+    {
+        class TapeDecoder
+        {
+        public:
+            bool decode(Reader &reader, std::string_view key, bool has_key, int depth)
+            {
+                uint8_t type_byte;
+                if (depth > MaxDepth || !reader.read(type_byte))
+                {
+                    return false;
+                }
+                Type type = static_cast<Type>(type_byte);
+
+                if (is_container(type))
+                {
+                    uint32_t count;
+                    if (!reader.read_count(type, count))
+                    {
+                        return false;
+                    }
+
+                    bool is_map = type == Type::Map || type == Type::LongMap;
+                    size_t index = add_node(is_map ? ValueType::Map : ValueType::List, key, has_key);
+                    m_nodes[index].child_count = count;
+
+                    std::string number_key;
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        std::string_view child_key;
+                        if (is_map)
+                        {
+                            uint8_t key_type;
+                            Scalar key_value;
+                            if (!reader.read(key_type) || !read_scalar(reader, static_cast<Type>(key_type), key_value))
+                            {
+                                return false;
+                            }
+                            if (key_value.kind == Scalar::Kind::Signed)
+                            {
+                                number_key = std::to_string(key_value.integer);
+                                child_key = number_key;
+                            }
+                            else if (key_value.kind == Scalar::Kind::Unsigned)
+                            {
+                                number_key = std::to_string(key_value.unsigned_integer);
+                                child_key = number_key;
+                            }
+                            else
+                            {
+                                child_key = key_value.bytes;
+                            }
+                        }
+
+                        if (!decode(reader, child_key, is_map, depth + 1))
+                        {
+                            return false;
+                        }
+                    }
+                    m_nodes[index].end = static_cast<uint32_t>(m_nodes.size());
+                    return true;
+                }
+
+                Scalar value;
+                if (!read_scalar(reader, type, value))
+                {
+                    return false;
+                }
+
+                if (value.kind == Scalar::Kind::Compressed)
+                {
+                    // Transparent: the inflated value takes the wrapper's place
+                    std::string inflated;
+                    if (!inflate_body(value.bytes, inflated))
+                    {
+                        return false;
+                    }
+                    Reader inner(inflated);
+                    return decode(inner, key, has_key, depth + 1);
+                }
+
+                size_t index = add_node(static_cast<ValueType>(0xFF), key, has_key);
+                ValueSnapshot::Node &node = m_nodes[index];
+                switch (value.kind)
+                {
+                case Scalar::Kind::Null:
+                case Scalar::Kind::Compressed:
+                    break;
+                case Scalar::Kind::Pass:
+                    node.unmapped = true;
+                    break;
+                case Scalar::Kind::Boolean:
+                    node.type = ValueType::Boolean;
+                    node.boolean = value.boolean;
+                    break;
+                case Scalar::Kind::Signed:
+                    node.type = ValueType::Integer;
+                    node.integer = value.integer;
+                    break;
+                case Scalar::Kind::Unsigned:
+                    node.type = ValueType::Integer;
+                    node.integer = static_cast<int64_t>(value.unsigned_integer);
+                    break;
+                case Scalar::Kind::Number:
+                    node.type = ValueType::Double;
+                    node.number = value.number;
+                    break;
+                case Scalar::Kind::String:
+                case Scalar::Kind::Binary:
+                    node.type = value.kind == Scalar::Kind::String ? ValueType::String : ValueType::Binary;
+                    node.string.offset = store(value.bytes);
+                    node.string.length = static_cast<uint32_t>(value.bytes.size());
+                    break;
+                case Scalar::Kind::DateTime:
+                    node.type = ValueType::DateTime;
+                    node.integer = static_cast<int64_t>(value.unsigned_integer);
+                    break;
+                }
+                node.end = static_cast<uint32_t>(m_nodes.size());
+                return true;
+            }
+
+            ValueSnapshot finish() const
+            {
+                return ValueSnapshot::from_tape(m_nodes, m_strings);
+            }
+
+        private:
+            size_t add_node(ValueType type, std::string_view key, bool has_key)
+            {
+                size_t index = m_nodes.size();
+                m_nodes.emplace_back();
+                m_nodes[index].type = type;
+                if (has_key)
+                {
+                    m_nodes[index].key_offset = store(key);
+                    m_nodes[index].key_length = static_cast<uint32_t>(key.size());
+                }
+                return index;
+            }
+
+            uint32_t store(std::string_view text)
+            {
+                uint32_t offset = static_cast<uint32_t>(m_strings.size());
+                m_strings.append(text);
+                return offset;
+            }
+
+            std::vector<ValueSnapshot::Node> m_nodes;
+            std::string m_strings;
+        };
+    }
+
+    bool to_text(std::string_view data, std::string &out)
+    {
+        Reader reader(data);
+        return render_text(reader, out, "", 0, 0);
+    }
+
+    bool to_json(std::string_view data, std::string &out)
+    {
+        Reader reader(data);
+        return render_json(reader, out, 0);
+    }
+
+    bool decode(std::string_view data, ValueSnapshot &out)
+    {
+        Reader reader(data);
+        TapeDecoder decoder;
+        if (!decoder.decode(reader, {}, false, 0))
+        {
+            return false;
+        }
+        out = decoder.finish();
+        return true;
+    }
+}
@@ -0,0 +1,527 @@
+#include <hydra/path_query.hpp>
+#include <hydra/tree_access.hpp>
+#include <charconv>
+#include <format>
+
+namespace hydra
+{
+    namespace
+    {
+        using Step = PathQuery::Step;
+        using Literal = PathQuery::Literal;
+        using Compare = PathQuery::Compare;
+        using detail::LiveTree;
+        using detail::SnapshotTree;
+
+        class Parser
+        {
+        public:
+            explicit Parser(std::string_view text) : m_text(text) {}
+
+            bool parse(std::vector<Step> &steps)
+            {
+                skip_spaces();
+                if (at_end())
+                {
+                    return fail("empty expression");
+                }
+
+                // The leading key has no '.'
+                if (peek() != '[' && !key_step(steps))
+                {
+                    return false;
+                }
+
+                while (skip_spaces(), !at_end())
+                {
+                    char c = m_text[m_pos++];
+                    if (c == '.')
+                    {
+                        if (!key_step(steps))
+                        {
+                            return false;
+                        }
+                    }
+                    else if (c == '[')
+                    {
+                        if (!selector(steps))
+                        {
+                            return false;
+                        }
+                    }
+                    else
+                    {
+                        --m_pos;
+                        return fail(std::format("unexpected '{}'", c));
+                    }
+                }
+                return true;
+            }
+
+            const std::string &error() const
+            {
+                return m_error;
+            }
+
+        private:
+            bool at_end() const
+            {
+                return m_pos >= m_text.size();
+            }
+
+            char peek() const
+            {
+                return at_end() ? '\0' : m_text[m_pos];
+            }
+
+            void skip_spaces()
+            {
+                while (!at_end() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t'))
+                {
+                    ++m_pos;
+                }
+            }
+
+            bool consume(std::string_view token)
+            {
+                if (m_text.substr(m_pos).starts_with(token))
+                {
+                    m_pos += token.size();
+                    return true;
+                }
+                return false;
+            }
+
+            bool fail(std::string message)
+            {
+                m_error = std::format("{} at column {}", message, m_pos + 1);
+                return false;
+            }
+
+            static bool ends_name(char c)
+            {
+                return std::string_view(".[]=!<> \t").find(c) != std::string_view::npos;
+            }
+
+            bool quoted(std::string &out)
+            {
+                size_t start = m_pos++;
+                out.clear();
+                while (!at_end())
+                {
+                    char c = m_text[m_pos++];
+                    if (c == '"')
+                    {
+                        return true;
+                    }
+                    if (c == '\\' && !at_end())
+                    {
+                        c = m_text[m_pos++];
+                    }
+                    out.push_back(c);
+                }
+                m_pos = start;
+                return fail("unterminated string");
+            }
+
+            bool name(std::string &out)
+            {
+                if (peek() == '"')
+                {
+                    return quoted(out);
+                }
+
+                size_t start = m_pos;
+                while (!at_end() && !ends_name(m_text[m_pos]))
+                {
+                    ++m_pos;
+                }
+                if (m_pos == start)
+                {
+                    return fail("expected a key");
+                }
+                out.assign(m_text.substr(start, m_pos - start));
+                return true;
+            }
+
+            bool key_step(std::vector<Step> &steps)
+            {
+                if (peek() == '*')
+                {
+                    ++m_pos;
+                    Step step;
+                    step.kind = Step::Kind::Children;
+                    steps.push_back(std::move(step));
+                    return true;
+                }
+
+                Step step;
+                step.kind = Step::Kind::Key;
+                if (!name(step.key))
+                {
+                    return false;
+                }
+                steps.push_back(std::move(step));
+                return true;
+            }
+
+            bool integer(int64_t &out)
+            {
+                const char *begin = m_text.data() + m_pos;
+                auto [end, ec] = std::from_chars(begin, m_text.data() + m_text.size(), out);
+                if (ec != std::errc())
+                {
+                    return fail("expected an integer");
+                }
+                m_pos += end - begin;
+                return true;
+            }
+
+            bool selector(std::vector<Step> &steps)
+            {
+                skip_spaces();
+                Step step;
+                step.kind = Step::Kind::Index;
+                char c = peek();
+                if (c == '*')
+                {
+                    ++m_pos;
+                    step.kind = Step::Kind::Children;
+                }
+                else if (c == '"')
+                {
+                    step.kind = Step::Kind::Key;
+                    if (!quoted(step.key))
+                    {
+                        return false;
+                    }
+                }
+                else if (c == '?')
+                {
+                    ++m_pos;
+                    step.kind = Step::Kind::Filter;
+                    if (!filter(step))
+                    {
+                        return false;
+                    }
+                }
+                else if (!integer(step.index))
+                {
+                    return false;
+                }
+
+                skip_spaces();
+                if (!consume("]"))
+                {
+                    return fail("expected ']'");
+                }
+                steps.push_back(std::move(step));
+                return true;
+            }
+
+            bool filter(Step &step)
+            {
+                skip_spaces();
+                do
+                {
+                    if (!name(step.field.emplace_back()))
+                    {
+                        return false;
+                    }
+                } while (consume("."));
+
+                skip_spaces();
+                // Two-character operators first, so "<=" is not read as "<"
+                static constexpr std::pair<std::string_view, Compare> Operators[] = {
+                    {"==", Compare::Equal},
+                    {"!=", Compare::NotEqual},
+                    {"<=", Compare::LessEqual},
+                    {">=", Compare::GreaterEqual},
+                    {"<", Compare::Less},
+                    {">", Compare::Greater},
+                };
+                bool found = false;
+                for (const auto &[token, compare] : Operators)
+                {
+                    if (consume(token))
+                    {
+                        step.compare = compare;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    return fail("expected a comparison");
+                }
+
+                skip_spaces();
+                return literal(step.literal);
+            }
+
+            bool literal(Literal &out)
+            {
+                if (peek() == '"')
+                {
+                    out.kind = Literal::Kind::String;
+                    return quoted(out.string);
+                }
+                if (consume("true") || consume("false"))
+                {
+                    out.kind = Literal::Kind::Boolean;
+                    out.boolean = m_text[m_pos - 4] == 't';
+                    return true;
+                }
+
+                // Integers stay exact; anything with a fraction or exponent is a double
+                const char *begin = m_text.data() + m_pos;
+                const char *end = m_text.data() + m_text.size();
+                auto integer_result = std::from_chars(begin, end, out.integer);
+                auto double_result = std::from_chars(begin, end, out.number);
+                if (double_result.ec != std::errc())
+                {
+                    return fail("expected a string, number, true or false");
+                }
+                if (integer_result.ec == std::errc() && integer_result.ptr == double_result.ptr)
+                {
+                    out.kind = Literal::Kind::Integer;
+                }
+                else
+                {
+                    out.kind = Literal::Kind::Double;
+                }
+                m_pos += double_result.ptr - begin;
+                return true;
+            }
+
+            std::string_view m_text;
+            size_t m_pos = 0;
+            std::string m_error;
+        };
+
+        template <typename T>
+        int three_way(T a, T b)
+        {
+            return a < b ? -1 : b < a ? 1 : 0;
+        }
+
+        bool holds(Compare compare, int order)
+        {
+            switch (compare)
+            {
+            case Compare::Equal:
+                return order == 0;
+            case Compare::NotEqual:
+                return order != 0;
+            case Compare::Less:
+                return order < 0;
+            case Compare::LessEqual:
+                return order <= 0;
+            case Compare::Greater:
+                return order > 0;
+            case Compare::GreaterEqual:
+                return order >= 0;
+            }
+            return false;
+        }
+
+        template <typename Tree>
+        bool matches(const typename Tree::Node &value, Compare compare, const Literal &literal)
+        {
+            ValueType type = Tree::type(value);
+            switch (literal.kind)
+            {
+            case Literal::Kind::String:
+                return type == ValueType::String && holds(compare, three_way(Tree::string(value), std::string_view(literal.string)));
+
+            case Literal::Kind::Boolean:
+                return type == ValueType::Boolean && holds(compare, three_way<int>(Tree::boolean(value), literal.boolean));
+
+            case Literal::Kind::Integer:
+            case Literal::Kind::Double:
+            {
+                if (type == ValueType::Integer && literal.kind == Literal::Kind::Integer)
+                {
+                    return holds(compare, three_way(Tree::integer(value), literal.integer));
+                }
+
+                double number;
+                if (type == ValueType::Integer)
+                {
+                    number = static_cast<double>(Tree::integer(value));
+                }
+                else if (type == ValueType::Double)
+                {
+                    number = Tree::number(value);
+                }
+                else
+                {
+                    return false;
+                }
+
+                double operand = literal.kind == Literal::Kind::Integer ? static_cast<double>(literal.integer) : literal.number;
+                if (number != number || operand != operand)
+                {
+                    // NaN is unordered: only != holds
+                    return compare == Compare::NotEqual;
+                }
+                return holds(compare, three_way(number, operand));
+            }
+            }
+            return false;
+        }
+
+        // Depth-first over the steps, so matches come out in document order
+        // and first() can stop at the first one
+        template <typename Tree>
+        class Runner
+        {
+        public:
+            using Node = typename Tree::Node;
+
+            Runner(const std::vector<Step> &steps, std::vector<Node> *out) : m_steps(steps), m_out(out) {}
+
+            // False once the first match was taken and no more are wanted
+            bool run(const Node &node, size_t index)
+            {
+                if (index == m_steps.size())
+                {
+                    ++m_count;
+                    if (!m_out)
+                    {
+                        m_first = node;
+                        return false;
+                    }
+                    m_out->push_back(node);
+                    return true;
+                }
+
+                const Step &step = m_steps[index];
+                switch (step.kind)
+                {
+                case Step::Kind::Key:
+                {
+                    Node child = Tree::child(node, step.key);
+                    return !Tree::valid(child) || run(child, index + 1);
+                }
+
+                case Step::Kind::Index:
+                {
+                    Node element = Tree::element(node, step.index);
+                    return !Tree::valid(element) || run(element, index + 1);
+                }
+
+                case Step::Kind::Children:
+                {
+                    bool more = true;
+                    Tree::children(node, [&](const Node &child) {
+                        more = !Tree::valid(child) || run(child, index + 1);
+                        return more;
+                    });
+                    return more;
+                }
+
+                case Step::Kind::Filter:
+                {
+                    bool more = true;
+                    Tree::children(node, [&](const Node &child) {
+                        if (Tree::valid(child) && passes(child, step))
+                        {
+                            more = run(child, index + 1);
+                        }
+                        return more;
+                    });
+                    return more;
+                }
+                }
+                return true;
+            }
+
+            size_t count() const
+            {
+                return m_count;
+            }
+
+            const Node &first() const
+            {
+                return m_first;
+            }
+
+        private:
+            static bool passes(const Node &element, const Step &step)
+            {
+                Node field = element;
+                for (const std::string &key : step.field)
+                {
+                    field = Tree::child(field, key);
+                    if (!Tree::valid(field))
+                    {
+                        return false;
+                    }
+                }
+                return matches<Tree>(field, step.compare, step.literal);
+            }
+
+            const std::vector<Step> &m_steps;
+            std::vector<Node> *m_out;
+            size_t m_count = 0;
+            Node m_first{};
+        };
+    }
+
+    std::optional<PathQuery> PathQuery::compile(std::string_view expression, std::string *error)
+    {
+        PathQuery query;
+        Parser parser(expression);
+        if (!parser.parse(query.m_steps))
+        {
+            if (error)
+            {
+                *error = parser.error();
+            }
+            return std::nullopt;
+        }
+        query.m_expression = expression;
+        return query;
+    }
+
+    size_t PathQuery::select(Value *root, std::vector<Value *> &out) const
+    {
+        Runner<LiveTree> runner(m_steps, &out);
+        if (root)
+        {
+            runner.run(root, 0);
+        }
+        return runner.count();
+    }
+
+    size_t PathQuery::select(const SnapshotValue &root, std::vector<SnapshotValue> &out) const
+    {
+        Runner<SnapshotTree> runner(m_steps, &out);
+        if (root.valid())
+        {
+            runner.run(root, 0);
+        }
+        return runner.count();
+    }
+
+    Value *PathQuery::first(Value *root) const
+    {
+        Runner<LiveTree> runner(m_steps, nullptr);
+        if (root)
+        {
+            runner.run(root, 0);
+        }
+        return runner.first();
+    }
+
+    SnapshotValue PathQuery::first(const SnapshotValue &root) const
+    {
+        Runner<SnapshotTree> runner(m_steps, nullptr);
+        if (root.valid())
+        {
+            runner.run(root, 0);
+        }
+        return runner.first();
+    }
+}
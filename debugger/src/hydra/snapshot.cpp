@@ -0,0 +1,184 @@
+#include <hydra/snapshot.hpp>
+#include <cstring>
+#include <vector>
+
+namespace hydra
+{
+    // Builds the tape into per-thread scratch buffers, which keep their
+    // capacity between captures, then copies it into one exact-size arena.
+    // Hooks therefore only pay for growth the first time a tree that large
+    // is seen on that thread.
+    class ValueSnapshot::Builder
+    {
+    public:
+        Builder()
+        {
+            m_nodes.clear();
+            m_strings.clear();
+        }
+
+        void append(Value *value, std::string_view key, bool has_key);
+        ValueSnapshot finish();
+
+    private:
+        uint32_t store(std::string_view text)
+        {
+            uint32_t offset = static_cast<uint32_t>(m_strings.size());
+            m_strings.append(text);
+            return offset;
+        }
+
+        static thread_local std::vector<Node> m_nodes;
+        static thread_local std::string m_strings;
+    };
+
+    thread_local std::vector<ValueSnapshot::Node> ValueSnapshot::Builder::m_nodes;
+    thread_local std::string ValueSnapshot::Builder::m_strings;
+
+    void ValueSnapshot::Builder::append(Value *value, std::string_view key, bool has_key)
+    {
+        size_t index = m_nodes.size();
+        m_nodes.emplace_back();
+        // Null children keep the same 0xFF type ValueVariant reports for them
+        m_nodes[index].type = value ? ValueTypeCache::type_of(value) : static_cast<ValueType>(0xFF);
+
+        if (has_key)
+        {
+            m_nodes[index].key_offset = store(key);
+            m_nodes[index].key_length = static_cast<uint32_t>(key.size());
+        }
+
+        // Note: m_nodes may reallocate while children are appended, so the
+        // node is always addressed by index below. The type is already known,
+        // so values are read directly rather than through ValueVariant::as.
+        switch (m_nodes[index].type)
+        {
+        case ValueType::Integer:
+            m_nodes[index].integer = static_cast<IntegerValue *>(value)->value();
+            break;
+
+        case ValueType::Double:
+            m_nodes[index].number = static_cast<DoubleValue *>(value)->value;
+            break;
+
+        case ValueType::Boolean:
+            m_nodes[index].boolean = static_cast<BooleanValue *>(value)->value;
+            break;
+
+        case ValueType::String:
+        {
+            const std::string &text = static_cast<StringValue *>(value)->value;
+            m_nodes[index].string.offset = store(text);
+            m_nodes[index].string.length = static_cast<uint32_t>(text.size());
+            break;
+        }
+
+        case ValueType::Map:
+        {
+            IterableMap *map = static_cast<IterableMap *>(value);
+            uint32_t count = 0;
+            for (auto it = map->begin(); it != map->end(); ++it, ++count)
+            {
+                auto [entry_key, entry_value] = *it;
+                append(entry_value.get(), entry_key, true);
+            }
+            m_nodes[index].child_count = count;
+            break;
+        }
+
+        case ValueType::List:
+        {
+            ListValue *list = static_cast<ListValue *>(value);
+            uint32_t count = 0;
+            for (auto it = list->begin(); it != list->end(); ++it, ++count)
+            {
+                append((*it).get(), {}, false);
+            }
+            m_nodes[index].child_count = count;
+            break;
+        }
+
+        case ValueType::DateTime:
+        case ValueType::HiResDateTime:
+        case ValueType::Binary:
+        case ValueType::Compressed:
+            // Layouts not mapped yet; only the type is kept
+            m_nodes[index].unmapped = true;
+            break;
+
+        default:
+            break;
+        }
+
+        m_nodes[index].end = static_cast<uint32_t>(m_nodes.size());
+    }
+
+    ValueSnapshot ValueSnapshot::Builder::finish()
+    {
+        return from_tape(m_nodes, m_strings);
+    }
+
+    ValueSnapshot ValueSnapshot::from_tape(std::span<const Node> nodes, std::string_view strings)
+    {
+        ValueSnapshot snapshot;
+        if (nodes.empty())
+        {
+            return snapshot;
+        }
+
+        size_t node_bytes = nodes.size() * sizeof(Node);
+        snapshot.m_arena_words = (node_bytes + strings.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        snapshot.m_arena = std::make_unique_for_overwrite<uint64_t[]>(snapshot.m_arena_words);
+        snapshot.m_node_count = static_cast<uint32_t>(nodes.size());
+
+        char *arena = reinterpret_cast<char *>(snapshot.m_arena.get());
+        std::memcpy(arena, nodes.data(), node_bytes);
+        std::memcpy(arena + node_bytes, strings.data(), strings.size());
+        snapshot.m_strings = arena + node_bytes;
+        return snapshot;
+    }
+
+    ValueSnapshot ValueSnapshot::capture(const ValueVariant &root)
+    {
+        if (!root.get())
+        {
+            return ValueSnapshot();
+        }
+
+        Builder builder;
+        builder.append(root.get(), {}, false);
+        return builder.finish();
+    }
+
+    SnapshotValue SnapshotValue::at(size_t index) const
+    {
+        if (!valid() || type() != ValueType::List || index >= size())
+        {
+            return SnapshotValue();
+        }
+
+        Iterator it = begin();
+        for (size_t i = 0; i < index; ++i)
+        {
+            ++it;
+        }
+        return *it;
+    }
+
+    SnapshotValue SnapshotValue::find(std::string_view key) const
+    {
+        if (!valid() || type() != ValueType::Map)
+        {
+            return SnapshotValue();
+        }
+
+        for (auto it = begin(); it != end(); ++it)
+        {
+            if (it.key() == key)
+            {
+                return *it;
+            }
+        }
+        return SnapshotValue();
+    }
+}
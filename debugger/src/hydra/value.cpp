@@ -1,12 +1,42 @@
 #include "hydra/value.hpp"
 #include <logging/logger.hpp>
 #include <hydra/request.hpp>
+#include <hydra/value_visitor.hpp>
+#include <algorithm>
 
 namespace hydra
 {
+    ValueType ValueTypeCache::learn(Value *value, uintptr_t vftable)
+    {
+        ValueType type = value->type();
+        if (vftable == 0 || (vftable & ~AddressMask) != 0)
+        {
+            return type;
+        }
+
+        uint64_t entry = (static_cast<uint64_t>(type) << TypeShift) | vftable;
+        for (size_t probe = 0, slot = home_slot(vftable); probe < Slots; ++probe, slot = (slot + 1) % Slots)
+        {
+            uint64_t expected = 0;
+            if (m_slots[slot].compare_exchange_strong(expected, entry, std::memory_order_acq_rel) || expected == entry)
+            {
+                break;
+            }
+        }
+        return type;
+    }
+
+    void ValueTypeCache::clear()
+    {
+        for (std::atomic<uint64_t> &slot : m_slots)
+        {
+            slot.store(0, std::memory_order_release);
+        }
+    }
+
     std::string Value::get_type_name()
     {
-        switch (type())
+        switch (ValueTypeCache::type_of(this))
         {
         case ValueType::Integer:
             return "Integer";
@@ -42,7 +72,7 @@ namespace hydra
 
     std::string IntegerValue::to_string()
     {
-        return std::to_string(value);
+        return std::to_string(value());
     }
 
     void DoubleValue::dtor() {}
@@ -164,27 +194,27 @@ namespace hydra
 
     const List* ListValue::get_list() const
     {
-        return list;
+        return list();
     }
 
     List::Iterator ListValue::begin() const
     {
-        return list->begin();
+        return list()->begin();
     }
 
     List::Iterator ListValue::end() const
     {
-        return list->end();
+        return list()->end();
     }
 
     size_t ListValue::size() const
     {
-        return list->size();
+        return list()->size();
     }
 
     ValueVariant ListValue::at(size_t index) const
     {
-        return list->at(index);
+        return list()->at(index);
     }
 
     std::string ListValue::to_string() const
@@ -193,7 +223,7 @@ namespace hydra
         result << "[";
 
         bool first = true;
-        for (auto it = list->begin(); it != list->end(); ++it)
+        for (auto it = list()->begin(); it != list()->end(); ++it)
         {
             if (!first)
             {
@@ -218,7 +248,7 @@ namespace hydra
 
     ValueType ValueVariant::type() const
     {
-        return m_value ? m_value->type() : static_cast<ValueType>(0xFF);
+        return m_value ? ValueTypeCache::type_of(m_value) : static_cast<ValueType>(0xFF);
     }
 
     std::string ValueVariant::to_string() const
@@ -226,7 +256,7 @@ namespace hydra
         if (!m_value)
             return "null";
 
-        switch (m_value->type())
+        switch (ValueTypeCache::type_of(m_value))
         {
         case ValueType::Integer:
             return std::to_string(as<int64_t>());
@@ -252,22 +282,117 @@ namespace hydra
         }
     }
 
-    std::pair<std::string, ValueVariant> MapIterator::operator*() const
+    namespace
+    {
+        // Keys resolved per shared descent; larger batches are split
+        constexpr size_t MaxBatchKeys = 64;
+
+        // order[lo, hi) indexes keys in ascending order; each node takes the
+        // keys equal to it and passes the smaller and larger ones down
+        size_t descend_many(const MapEntry *node, std::span<const std::string_view> keys, std::span<Value *> values,
+                            const uint8_t *order, size_t lo, size_t hi, size_t depth)
+        {
+            size_t found = 0;
+            while (lo < hi && !MapValue::is_nil(node) && depth < MapValue::MaxTreeDepth)
+            {
+                std::string_view node_key = node->key->value;
+                const uint8_t *first = std::lower_bound(order + lo, order + hi, node_key,
+                                                        [&](uint8_t i, std::string_view k) { return keys[i] < k; });
+                const uint8_t *last = std::upper_bound(first, order + hi, node_key,
+                                                       [&](std::string_view k, uint8_t i) { return k < keys[i]; });
+                for (const uint8_t *it = first; it != last; ++it)
+                {
+                    values[*it] = node->value;
+                    ++found;
+                }
+
+                size_t mid = static_cast<size_t>(first - order);
+                size_t upper = static_cast<size_t>(last - order);
+                ++depth;
+
+                // When both sides have keys, recurse into the one with fewer and
+                // continue with the other in this loop. Each recursion at least
+                // halves the keys, so the stack stays within log2(MaxBatchKeys)
+                // frames.
+                if (lo < mid && upper < hi)
+                {
+                    if (mid - lo <= hi - upper)
+                    {
+                        found += descend_many(node->left_child, keys, values, order, lo, mid, depth);
+                        node = node->right_child;
+                        lo = upper;
+                    }
+                    else
+                    {
+                        found += descend_many(node->right_child, keys, values, order, upper, hi, depth);
+                        node = node->left_child;
+                        hi = mid;
+                    }
+                }
+                else if (lo < mid)
+                {
+                    node = node->left_child;
+                    hi = mid;
+                }
+                else
+                {
+                    node = node->right_child;
+                    lo = upper;
+                }
+            }
+            return found;
+        }
+    }
+
+    size_t MapValue::get_many(std::span<const std::string_view> keys, std::span<Value *> values) const
+    {
+        size_t count = std::min(keys.size(), values.size());
+        std::fill_n(values.begin(), count, nullptr);
+
+        MapEntry *node_head = head();
+        if (!node_head)
+        {
+            return 0;
+        }
+        const MapEntry *root = static_cast<const MapEntry *>(node_head->padding01);
+
+        size_t found = 0;
+        for (size_t base = 0; base < count; base += MaxBatchKeys)
+        {
+            size_t batch = std::min(MaxBatchKeys, count - base);
+            std::span<const std::string_view> batch_keys = keys.subspan(base, batch);
+            std::span<Value *> batch_values = values.subspan(base, batch);
+
+            uint8_t order[MaxBatchKeys];
+            for (size_t i = 0; i < batch; ++i)
+            {
+                order[i] = static_cast<uint8_t>(i);
+            }
+            std::sort(order, order + batch, [&](uint8_t a, uint8_t b) { return batch_keys[a] < batch_keys[b]; });
+
+            found += descend_many(root, batch_keys, batch_values, order, 0, batch, 0);
+        }
+        return found;
+    }
+
+    std::pair<std::string_view, ValueVariant> MapIterator::operator*() const
     {
-        if (m_index >= m_entries.size())
+        MapEntry *node = current();
+        if (!node)
         {
             throw std::runtime_error("Dereferencing invalid iterator");
         }
-        return {m_entries[m_index].first, ValueVariant(m_entries[m_index].second)};
+        return {node->key->value, ValueVariant(node->value)};
     }
 
     ValueVariant MapIterator::value() const
     {
-        if (m_index >= m_entries.size())
+        MapEntry *node = current();
+        if (!node)
         {
             throw std::runtime_error("Accessing value of invalid iterator");
         }
-        return ValueVariant(m_entries[m_index].second);
+        return ValueVariant(node->value);
     }
 
     void ValueUtils::log_request_data(const Request *request)
@@ -278,10 +403,10 @@ namespace hydra
             return;
         }
 
-        LOG_INFO("Response: {}", request->endpoint);
-        LOG_INFO("Response Code: {}", request->response_code);
+        LOG_INFO("Response: {}", request->endpoint());
+        LOG_INFO("Response Code: {}", request->response_code());
 
-        if (!request->data)
+        if (!request->data())
         {
             LOG_INFO("No data");
             return;
@@ -293,74 +418,24 @@ namespace hydra
 
     void ValueUtils::print_value(const ValueVariant &value, const std::string &prefix, int indent_level)
     {
-        std::string indent(indent_level * 2, ' ');
-
-        switch (value.type())
-        {
-        case ValueType::Integer:
-            LOG_INFO("{}{}Integer: {}", indent, prefix, value.as<int64_t>());
-            break;
-
-        case ValueType::Double:
-            LOG_INFO("{}{}Double: {}", indent, prefix, value.as<double>());
-            break;
-
-        case ValueType::Boolean:
-            LOG_INFO("{}{}Boolean: {}", indent, prefix, value.as<bool>() ? "true" : "false");
-            break;
-
-        case ValueType::String:
-            LOG_INFO("{}{}String: '{}'", indent, prefix, value.as<std::string>());
-            break;
-
-        case ValueType::Map:
-        {
-            LOG_INFO("{}{}Map:", indent, prefix);
-            MapValue *mapValue = static_cast<MapValue *>(value.get());
-            if (mapValue)
-            {
-                IterableMap *iterableMap = static_cast<IterableMap *>(mapValue);
-                if (iterableMap)
-                {
-                    for (auto it = iterableMap->begin(); it != iterableMap->end(); ++it)
-                    {
-                        auto [key, subValue] = *it;
-                        print_value(subValue, std::format("'{}' => ", key), indent_level + 1);
-                    }
-                }
-            }
-            break;
-        }
-
-        case ValueType::List:
+        // Skip the walk when nothing would be printed
+        if (!LOG_ENABLED(core::logging::LogLevel::Info))
         {
-            ListValue *listValue = static_cast<ListValue *>(value.get());
-            LOG_INFO("{}{}List with {} items:", indent, prefix, listValue->size());
-
-            int index = 0;
-            for (auto it = listValue->begin(); it != listValue->end(); ++it, ++index)
-            {
-                print_value(*it, std::format("[{}]: ", index), indent_level + 1);
-            }
-            break;
+            return;
         }
 
-        case ValueType::DateTime:
-        case ValueType::HiResDateTime:
-            LOG_INFO("{}{}DateTime: {}", indent, prefix, value.to_string());
-            break;
-
-        case ValueType::Binary:
-            LOG_INFO("{}{}Binary data", indent, prefix);
-            break;
-
-        case ValueType::Compressed:
-            LOG_INFO("{}{}Compressed data", indent, prefix);
-            break;
+        // Rendered once into a per-thread buffer, then logged a line at a time
+        thread_local std::string buffer;
+        buffer.clear();
+        TextEmitter emitter(buffer, prefix, indent_level);
+        visit(value.get(), emitter);
 
-        default:
-            LOG_INFO("{}{}Unknown type", indent, prefix);
-            break;
+        std::string_view text = buffer;
+        while (!text.empty())
+        {
+            size_t end = text.find('\n');
+            LOG_INFO("{}", text.substr(0, end));
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
         }
     }
 }
\ No newline at end of file
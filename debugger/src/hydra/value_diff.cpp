@@ -0,0 +1,297 @@
+#include <hydra/value_diff.hpp>
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+namespace hydra
+{
+    namespace
+    {
+        using Node = ValueSnapshot::Node;
+
+        // splitmix64 finalizer
+        uint64_t mix(uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xBF58476D1CE4E5B9ull;
+            x ^= x >> 27;
+            x *= 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        uint64_t hash_bytes(std::string_view bytes)
+        {
+            return static_cast<uint64_t>(std::hash<std::string_view>{}(bytes));
+        }
+
+        // Scalar payload as hashed; also what same_scalar compares for the
+        // non-string types
+        uint64_t scalar_bits(const Node &node)
+        {
+            switch (node.type)
+            {
+            case ValueType::Double:
+                return std::bit_cast<uint64_t>(node.number);
+            case ValueType::Boolean:
+                return node.boolean ? 1 : 0;
+            case ValueType::Integer:
+            case ValueType::DateTime:
+                return static_cast<uint64_t>(node.integer);
+            default:
+                return 0;
+            }
+        }
+
+        bool has_bytes(ValueType type)
+        {
+            return type == ValueType::String || type == ValueType::Binary;
+        }
+
+        bool is_container(ValueType type)
+        {
+            return type == ValueType::Map || type == ValueType::List;
+        }
+
+        class Differ
+        {
+        public:
+            Differ(const ValueSnapshot &old_tree, const ValueSnapshot &new_tree, std::vector<ValueDifference> &out)
+                : m_old(old_tree),
+                  m_new(new_tree),
+                  m_old_hashes(subtree_hashes(old_tree)),
+                  m_new_hashes(subtree_hashes(new_tree)),
+                  m_out(out)
+            {
+            }
+
+            void compare(uint32_t old_index, uint32_t new_index)
+            {
+                const Node &old_node = m_old.nodes()[old_index];
+                const Node &new_node = m_new.nodes()[new_index];
+
+                if (old_node.type != new_node.type)
+                {
+                    report(ValueDifference::Kind::Changed, SnapshotValue(&m_old, old_index), SnapshotValue(&m_new, new_index));
+                    return;
+                }
+
+                if (!is_container(old_node.type))
+                {
+                    if (!same_scalar(old_node, new_node))
+                    {
+                        report(ValueDifference::Kind::Changed, SnapshotValue(&m_old, old_index), SnapshotValue(&m_new, new_index));
+                    }
+                    return;
+                }
+
+                // Identical subtrees are skipped without being walked
+                if (m_old_hashes[old_index] == m_new_hashes[new_index])
+                {
+                    return;
+                }
+
+                if (old_node.type == ValueType::Map)
+                {
+                    compare_maps(old_index, new_index);
+                }
+                else
+                {
+                    compare_lists(old_index, new_index);
+                }
+            }
+
+        private:
+            using Entry = std::pair<std::string_view, uint32_t>;
+
+            bool same_scalar(const Node &old_node, const Node &new_node) const
+            {
+                // A value the debugger could not read is not the value it
+                // stands in for, even where the payloads match (a Pass and a
+                // real null)
+                if (old_node.unmapped != new_node.unmapped)
+                {
+                    return false;
+                }
+                if (has_bytes(old_node.type))
+                {
+                    return m_old.string(old_node) == m_new.string(new_node);
+                }
+                return scalar_bits(old_node) == scalar_bits(new_node);
+            }
+
+            static void sorted_entries(const ValueSnapshot &snapshot, uint32_t index, std::vector<Entry> &entries)
+            {
+                std::span<const Node> nodes = snapshot.nodes();
+                entries.reserve(nodes[index].child_count);
+                for (uint32_t child = index + 1; child < nodes[index].end; child = nodes[child].end)
+                {
+                    entries.emplace_back(snapshot.key(nodes[child]), child);
+                }
+                std::sort(entries.begin(), entries.end());
+            }
+
+            void compare_maps(uint32_t old_index, uint32_t new_index)
+            {
+                // Captures keep the server's key order, which need not be
+                // sorted, so both sides are sorted before merging
+                std::vector<Entry> old_entries;
+                std::vector<Entry> new_entries;
+                sorted_entries(m_old, old_index, old_entries);
+                sorted_entries(m_new, new_index, new_entries);
+
+                size_t path_length = m_path.size();
+                auto old_it = old_entries.begin();
+                auto new_it = new_entries.begin();
+                while (old_it != old_entries.end() || new_it != new_entries.end())
+                {
+                    int order = old_it == old_entries.end()   ? 1
+                                : new_it == new_entries.end() ? -1
+                                                              : old_it->first.compare(new_it->first);
+
+                    append_key(order <= 0 ? old_it->first : new_it->first);
+                    if (order < 0)
+                    {
+                        report(ValueDifference::Kind::Removed, SnapshotValue(&m_old, old_it->second), SnapshotValue());
+                        ++old_it;
+                    }
+                    else if (order > 0)
+                    {
+                        report(ValueDifference::Kind::Added, SnapshotValue(), SnapshotValue(&m_new, new_it->second));
+                        ++new_it;
+                    }
+                    else
+                    {
+                        compare(old_it->second, new_it->second);
+                        ++old_it;
+                        ++new_it;
+                    }
+                    m_path.resize(path_length);
+                }
+            }
+
+            void compare_lists(uint32_t old_index, uint32_t new_index)
+            {
+                std::span<const Node> old_nodes = m_old.nodes();
+                std::span<const Node> new_nodes = m_new.nodes();
+                uint32_t old_child = old_index + 1;
+                uint32_t new_child = new_index + 1;
+                uint32_t old_end = old_nodes[old_index].end;
+                uint32_t new_end = new_nodes[new_index].end;
+
+                size_t path_length = m_path.size();
+                for (size_t position = 0; old_child < old_end || new_child < new_end; ++position)
+                {
+                    append_index(position);
+                    if (new_child >= new_end)
+                    {
+                        report(ValueDifference::Kind::Removed, SnapshotValue(&m_old, old_child), SnapshotValue());
+                        old_child = old_nodes[old_child].end;
+                    }
+                    else if (old_child >= old_end)
+                    {
+                        report(ValueDifference::Kind::Added, SnapshotValue(), SnapshotValue(&m_new, new_child));
+                        new_child = new_nodes[new_child].end;
+                    }
+                    else
+                    {
+                        compare(old_child, new_child);
+                        old_child = old_nodes[old_child].end;
+                        new_child = new_nodes[new_child].end;
+                    }
+                    m_path.resize(path_length);
+                }
+            }
+
+            void append_key(std::string_view key)
+            {
+                if (!m_path.empty())
+                {
+                    m_path.push_back('.');
+                }
+                m_path.append(key);
+            }
+
+            void append_index(size_t index)
+            {
+                m_path.push_back('[');
+                m_path += std::to_string(index);
+                m_path.push_back(']');
+            }
+
+            void report(ValueDifference::Kind kind, SnapshotValue old_value, SnapshotValue new_value)
+            {
+                m_out.push_back(ValueDifference{kind, m_path, old_value, new_value});
+            }
+
+            const ValueSnapshot &m_old;
+            const ValueSnapshot &m_new;
+            std::vector<uint64_t> m_old_hashes;
+            std::vector<uint64_t> m_new_hashes;
+            std::vector<ValueDifference> &m_out;
+            std::string m_path;
+        };
+    }
+
+    std::vector<uint64_t> subtree_hashes(const ValueSnapshot &snapshot)
+    {
+        std::span<const Node> nodes = snapshot.nodes();
+        std::vector<uint64_t> hashes(nodes.size());
+
+        // Children follow their parent on the tape, so walking it backwards
+        // hashes every child before the node that contains it
+        for (size_t i = nodes.size(); i-- > 0;)
+        {
+            const Node &node = nodes[i];
+            uint64_t hash = mix((static_cast<uint64_t>(node.type) + 1) | (node.unmapped ? 1ull << 32 : 0));
+
+            if (node.type == ValueType::Map)
+            {
+                // Summed, so entry order does not matter; the key is mixed
+                // into each entry so swapping two values does
+                for (uint32_t child = static_cast<uint32_t>(i) + 1; child < node.end; child = nodes[child].end)
+                {
+                    hash += mix(hash_bytes(snapshot.key(nodes[child])) ^ mix(hashes[child]));
+                }
+            }
+            else if (node.type == ValueType::List)
+            {
+                for (uint32_t child = static_cast<uint32_t>(i) + 1; child < node.end; child = nodes[child].end)
+                {
+                    hash = mix(hash ^ hashes[child]) + 0x9E3779B97F4A7C15ull;
+                }
+            }
+            else if (has_bytes(node.type))
+            {
+                hash ^= hash_bytes(snapshot.string(node));
+            }
+            else
+            {
+                hash ^= mix(scalar_bits(node));
+            }
+
+            hashes[i] = mix(hash ^ node.child_count);
+        }
+        return hashes;
+    }
+
+    std::vector<ValueDifference> diff(const ValueSnapshot &old_tree, const ValueSnapshot &new_tree)
+    {
+        std::vector<ValueDifference> differences;
+        if (old_tree.empty() || new_tree.empty())
+        {
+            if (!old_tree.empty() || !new_tree.empty())
+            {
+                differences.push_back(ValueDifference{
+                    old_tree.empty() ? ValueDifference::Kind::Added : ValueDifference::Kind::Removed,
+                    std::string(), old_tree.root(), new_tree.root()});
+            }
+            return differences;
+        }
+
+        Differ differ(old_tree, new_tree, differences);
+        differ.compare(0, 0);
+        return differences;
+    }
+}
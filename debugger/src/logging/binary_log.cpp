@@ -0,0 +1,505 @@
+#include <logging/binary_log.hpp>
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace core::logging
+{
+
+    namespace
+    {
+        struct SiteRegistry
+        {
+            std::mutex mutex;
+            std::vector<const LogSite *> sites;
+        };
+
+        SiteRegistry &getSiteRegistry()
+        {
+            static SiteRegistry registry;
+            return registry;
+        }
+
+        // Marks the thread's staging buffer for collection once the thread exits
+        struct ThreadBufferHolder
+        {
+            StagingBuffer *buffer = nullptr;
+
+            ~ThreadBufferHolder()
+            {
+                if (buffer)
+                {
+                    buffer->retired.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local ThreadBufferHolder threadBufferHolder;
+
+        struct DecodedArg
+        {
+            binary::ArgType type;
+            int64_t integer = 0;
+            uint64_t unsignedInteger = 0;
+            double floating = 0.0;
+            std::string_view string;
+        };
+
+        template <typename T>
+        bool readRaw(const uint8_t *&cursor, const uint8_t *end, T &out)
+        {
+            if (static_cast<size_t>(end - cursor) < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&out, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return true;
+        }
+
+        bool decodeArgs(const uint8_t *payload, size_t size, std::vector<DecodedArg> &args)
+        {
+            const uint8_t *cursor = payload;
+            const uint8_t *end = payload + size;
+
+            while (cursor < end)
+            {
+                DecodedArg arg;
+                arg.type = static_cast<binary::ArgType>(*cursor++);
+
+                switch (arg.type)
+                {
+                case binary::ArgType::Int64:
+                    if (!readRaw(cursor, end, arg.integer))
+                        return false;
+                    break;
+                case binary::ArgType::UInt64:
+                case binary::ArgType::Pointer:
+                    if (!readRaw(cursor, end, arg.unsignedInteger))
+                        return false;
+                    break;
+                case binary::ArgType::Double:
+                    if (!readRaw(cursor, end, arg.floating))
+                        return false;
+                    break;
+                case binary::ArgType::Bool:
+                case binary::ArgType::Char:
+                {
+                    uint8_t byte;
+                    if (!readRaw(cursor, end, byte))
+                        return false;
+                    arg.integer = byte;
+                    break;
+                }
+                case binary::ArgType::String:
+                {
+                    uint32_t length;
+                    if (!readRaw(cursor, end, length) || static_cast<size_t>(end - cursor) < length)
+                        return false;
+                    arg.string = std::string_view(reinterpret_cast<const char *>(cursor), length);
+                    cursor += length;
+                    break;
+                }
+                default:
+                    return false;
+                }
+
+                args.push_back(arg);
+            }
+
+            return true;
+        }
+
+        template <typename T>
+        void appendFormatted(std::string &out, std::string_view spec, const T &value)
+        {
+            if (spec.empty())
+            {
+                std::format_to(std::back_inserter(out), "{}", value);
+                return;
+            }
+
+            std::string pattern = "{:";
+            pattern += spec;
+            pattern += '}';
+            std::vformat_to(std::back_inserter(out), pattern, std::make_format_args(value));
+        }
+
+        void appendArg(std::string &out, std::string_view spec, const DecodedArg &arg)
+        {
+            try
+            {
+                switch (arg.type)
+                {
+                case binary::ArgType::Int64:
+                    appendFormatted(out, spec, arg.integer);
+                    break;
+                case binary::ArgType::UInt64:
+                    appendFormatted(out, spec, arg.unsignedInteger);
+                    break;
+                case binary::ArgType::Double:
+                    appendFormatted(out, spec, arg.floating);
+                    break;
+                case binary::ArgType::Bool:
+                {
+                    bool value = arg.integer != 0;
+                    appendFormatted(out, spec, value);
+                    break;
+                }
+                case binary::ArgType::Char:
+                {
+                    char value = static_cast<char>(arg.integer);
+                    appendFormatted(out, spec, value);
+                    break;
+                }
+                case binary::ArgType::String:
+                    appendFormatted(out, spec, arg.string);
+                    break;
+                case binary::ArgType::Pointer:
+                {
+                    const void *value = reinterpret_cast<const void *>(static_cast<uintptr_t>(arg.unsignedInteger));
+                    appendFormatted(out, spec, value);
+                    break;
+                }
+                }
+            }
+            catch (const std::format_error &)
+            {
+                out += "{?}";
+            }
+        }
+    }
+
+    std::string binary::formatMessage(std::string_view format, const uint8_t *payload, size_t size)
+    {
+        std::vector<DecodedArg> args;
+        if (!decodeArgs(payload, size, args))
+        {
+            return std::format("<corrupt record: {}>", format);
+        }
+
+        std::string out;
+        out.reserve(format.size() + size);
+
+        size_t nextIndex = 0;
+        for (size_t i = 0; i < format.size(); ++i)
+        {
+            char c = format[i];
+            if (c == '}')
+            {
+                out += '}';
+                if (i + 1 < format.size() && format[i + 1] == '}')
+                {
+                    ++i;
+                }
+                continue;
+            }
+
+            if (c != '{')
+            {
+                out += c;
+                continue;
+            }
+
+            if (i + 1 < format.size() && format[i + 1] == '{')
+            {
+                out += '{';
+                ++i;
+                continue;
+            }
+
+            size_t close = format.find('}', i + 1);
+            if (close == std::string_view::npos)
+            {
+                out += format.substr(i);
+                break;
+            }
+
+            std::string_view field = format.substr(i + 1, close - i - 1);
+            std::string_view spec;
+            size_t colon = field.find(':');
+            if (colon != std::string_view::npos)
+            {
+                spec = field.substr(colon + 1);
+                field = field.substr(0, colon);
+            }
+
+            size_t index = nextIndex++;
+            if (!field.empty())
+            {
+                index = 0;
+                for (char digit : field)
+                {
+                    index = index * 10 + static_cast<size_t>(digit - '0');
+                }
+            }
+
+            if (index < args.size())
+            {
+                appendArg(out, spec, args[index]);
+            }
+            else
+            {
+                out += "{?}";
+            }
+
+            i = close;
+        }
+
+        return out;
+    }
+
+    StagingBuffer::StagingBuffer(size_t capacity)
+        : m_mask(std::bit_ceil(std::max<size_t>(capacity, 1024)) - 1),
+          m_storage(std::make_unique<uint8_t[]>(m_mask + 1))
+    {
+        m_scratch.reserve(256);
+    }
+
+    bool StagingBuffer::push(const binary::RecordHeader &header, const uint8_t *payload)
+    {
+        size_t needed = sizeof(header) + header.payloadSize;
+        size_t head = m_produced.load(std::memory_order_relaxed);
+        size_t tail = m_consumed.load(std::memory_order_acquire);
+        if ((m_mask + 1) - (head - tail) < needed)
+        {
+            return false;
+        }
+
+        copyIn(head, &header, sizeof(header));
+        copyIn(head + sizeof(header), payload, header.payloadSize);
+        m_produced.store(head + needed, std::memory_order_release);
+        return true;
+    }
+
+    void StagingBuffer::copyIn(size_t pos, const void *data, size_t size)
+    {
+        size_t offset = pos & m_mask;
+        size_t first = std::min(size, m_mask + 1 - offset);
+        std::memcpy(m_storage.get() + offset, data, first);
+        std::memcpy(m_storage.get(), static_cast<const uint8_t *>(data) + first, size - first);
+    }
+
+    void StagingBuffer::copyOut(size_t offset, void *out, size_t size) const
+    {
+        size_t pos = (m_consumed.load(std::memory_order_relaxed) + offset) & m_mask;
+        size_t first = std::min(size, m_mask + 1 - pos);
+        std::memcpy(out, m_storage.get() + pos, first);
+        std::memcpy(static_cast<uint8_t *>(out) + first, m_storage.get(), size - first);
+    }
+
+    BinaryLogger &getBinaryLogger()
+    {
+        static BinaryLogger instance;
+        return instance;
+    }
+
+    BinaryLogger::~BinaryLogger()
+    {
+        stop();
+    }
+
+    uint32_t BinaryLogger::registerSite(const LogSite *site)
+    {
+        SiteRegistry &registry = getSiteRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sites.push_back(site);
+        return static_cast<uint32_t>(registry.sites.size() - 1);
+    }
+
+    const LogSite *BinaryLogger::lookupSite(uint32_t id)
+    {
+        if (id >= m_siteCache.size())
+        {
+            SiteRegistry &registry = getSiteRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            m_siteCache = registry.sites;
+        }
+        return id < m_siteCache.size() ? m_siteCache[id] : nullptr;
+    }
+
+    StagingBuffer *BinaryLogger::threadBuffer()
+    {
+        if (threadBufferHolder.buffer)
+        {
+            return threadBufferHolder.buffer;
+        }
+
+        auto buffer = std::make_unique<StagingBuffer>(m_options.threadBufferSize);
+        threadBufferHolder.buffer = buffer.get();
+
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        m_buffers.push_back(std::move(buffer));
+        return threadBufferHolder.buffer;
+    }
+
+    bool BinaryLogger::start(const BinaryLogOptions &options)
+    {
+        if (m_running.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        m_options = options;
+        m_siteWritten.clear();
+
+        if (!m_options.path.empty())
+        {
+            m_file.open(m_options.path, std::ios::binary | std::ios::trunc);
+            if (!m_file.is_open())
+            {
+                return false;
+            }
+            m_file.write(binary::FileMagic, sizeof(binary::FileMagic));
+            m_file.write(reinterpret_cast<const char *>(&binary::FileVersion), sizeof(binary::FileVersion));
+        }
+
+        m_running.store(true, std::memory_order_release);
+        m_consumer = std::thread(&BinaryLogger::consumerLoop, this);
+        s_active.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void BinaryLogger::stop()
+    {
+        if (!m_running.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        s_active.store(false, std::memory_order_release);
+        m_running.store(false, std::memory_order_release);
+        if (m_consumer.joinable())
+        {
+            m_consumer.join();
+        }
+
+        if (m_file.is_open())
+        {
+            m_file.close();
+        }
+    }
+
+    void BinaryLogger::consumerLoop()
+    {
+        std::vector<StagingBuffer *> buffers;
+        for (;;)
+        {
+            // Read before draining so the final pass sees every record pushed before stop()
+            bool running = m_running.load(std::memory_order_acquire);
+
+            {
+                std::lock_guard<std::mutex> lock(m_buffersMutex);
+                buffers.clear();
+                for (const auto &buffer : m_buffers)
+                {
+                    buffers.push_back(buffer.get());
+                }
+            }
+
+            bool drained = false;
+            for (StagingBuffer *buffer : buffers)
+            {
+                drained |= drain(*buffer);
+            }
+
+            {
+                // Only this thread removes buffers, so the raw pointers above stay valid
+                std::lock_guard<std::mutex> lock(m_buffersMutex);
+                std::erase_if(m_buffers, [](const std::unique_ptr<StagingBuffer> &buffer)
+                              { return buffer->retired.load(std::memory_order_acquire) && buffer->readable() == 0; });
+            }
+
+            if (!running)
+            {
+                break;
+            }
+
+            if (!drained)
+            {
+                if (m_file.is_open())
+                {
+                    m_file.flush();
+                }
+                std::this_thread::sleep_for(m_options.pollInterval);
+            }
+        }
+
+        if (m_file.is_open())
+        {
+            m_file.flush();
+        }
+    }
+
+    bool BinaryLogger::drain(StagingBuffer &buffer)
+    {
+        size_t available = buffer.readable();
+        size_t offset = 0;
+
+        // A header and its payload are published together, so a visible header
+        // always has its full payload behind it
+        while (available - offset >= sizeof(binary::RecordHeader))
+        {
+            binary::RecordHeader header;
+            buffer.copyOut(offset, &header, sizeof(header));
+
+            m_payload.resize(header.payloadSize);
+            buffer.copyOut(offset + sizeof(header), m_payload.data(), header.payloadSize);
+            offset += sizeof(header) + header.payloadSize;
+
+            process(header, m_payload.data());
+        }
+
+        buffer.consume(offset);
+        return offset != 0;
+    }
+
+    void BinaryLogger::process(const binary::RecordHeader &header, const uint8_t *payload)
+    {
+        const LogSite *site = lookupSite(header.siteId);
+        if (!site)
+        {
+            return;
+        }
+
+        if (!m_file.is_open())
+        {
+            auto since_epoch = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(header.timestampNs));
+            getLogger().submit(LogRecord{site->level,
+                                         site->loc,
+                                         std::chrono::system_clock::time_point(since_epoch),
+                                         binary::formatMessage(site->format, payload, header.payloadSize)});
+            return;
+        }
+
+        if (header.siteId >= m_siteWritten.size())
+        {
+            m_siteWritten.resize(header.siteId + 1, false);
+        }
+
+        if (!m_siteWritten[header.siteId])
+        {
+            std::string_view file = site->loc.file_name();
+            uint8_t level = static_cast<uint8_t>(site->level);
+            uint32_t line = site->loc.line();
+            uint16_t fileLength = static_cast<uint16_t>(file.size());
+            uint16_t formatLength = static_cast<uint16_t>(site->format.size());
+
+            m_file.put(static_cast<char>(binary::EntryTag::Site));
+            m_file.write(reinterpret_cast<const char *>(&header.siteId), sizeof(header.siteId));
+            m_file.write(reinterpret_cast<const char *>(&level), sizeof(level));
+            m_file.write(reinterpret_cast<const char *>(&line), sizeof(line));
+            m_file.write(reinterpret_cast<const char *>(&fileLength), sizeof(fileLength));
+            m_file.write(file.data(), fileLength);
+            m_file.write(reinterpret_cast<const char *>(&formatLength), sizeof(formatLength));
+            m_file.write(site->format.data(), formatLength);
+            m_siteWritten[header.siteId] = true;
+        }
+
+        m_file.put(static_cast<char>(binary::EntryTag::Record));
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_file.write(reinterpret_cast<const char *>(payload), header.payloadSize);
+    }
+
+}
@@ -0,0 +1,573 @@
+#include <logging/capture_store.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <logging/logger.hpp>
+#include <zlib.h>
+
+#ifdef CAPTURE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace core::logging
+{
+
+    namespace
+    {
+        constexpr std::string_view SegmentPrefix = "segment_";
+
+        // Sequence number of a segment file name, or 0 if it is not one
+        uint32_t segmentSequence(const std::filesystem::path &path)
+        {
+            std::string name = path.filename().string();
+            if (!name.starts_with(SegmentPrefix) || path.extension() != capture::SegmentExtension)
+            {
+                return 0;
+            }
+
+            std::string digits = path.stem().string().substr(SegmentPrefix.size());
+            if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            {
+                return 0;
+            }
+            return static_cast<uint32_t>(std::stoul(digits));
+        }
+
+        template <typename T>
+        void appendRaw(std::string &buffer, const T &value)
+        {
+            buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        // zlib only looks at the last 32KB of a dictionary anyway
+        constexpr size_t MaxDictionaryBytes = 32 * 1024;
+
+        // Bounds dictionary memory when endpoints carry unique ids in their path
+        constexpr size_t MaxDictionaryEndpoints = 1024;
+    }
+
+    // Owns the zlib/zstd contexts so they are allocated once and reset per record
+    class CaptureCodec
+    {
+    public:
+        explicit CaptureCodec(int level) : m_level(level) {}
+
+        ~CaptureCodec()
+        {
+            if (m_deflateReady)
+            {
+                deflateEnd(&m_deflate);
+            }
+            if (m_inflateReady)
+            {
+                inflateEnd(&m_inflate);
+            }
+#ifdef CAPTURE_HAVE_ZSTD
+            ZSTD_freeCCtx(m_zstdCompress);
+            ZSTD_freeDCtx(m_zstdDecompress);
+#endif
+        }
+
+        static bool supports(capture::Compression type)
+        {
+#ifdef CAPTURE_HAVE_ZSTD
+            return type == capture::Compression::Zlib || type == capture::Compression::Zstd;
+#else
+            return type == capture::Compression::Zlib;
+#endif
+        }
+
+        // Replaces out with the compressed input
+        bool compress(capture::Compression type, std::string_view input, std::string_view dictionary, std::string &out)
+        {
+            if (type == capture::Compression::Zlib)
+            {
+                if (!m_deflateReady)
+                {
+                    m_deflate = {};
+                    m_deflateReady = deflateInit(&m_deflate, m_level) == Z_OK;
+                    if (!m_deflateReady)
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    deflateReset(&m_deflate);
+                }
+
+                if (!dictionary.empty() &&
+                    deflateSetDictionary(&m_deflate, reinterpret_cast<const Bytef *>(dictionary.data()),
+                                         static_cast<uInt>(dictionary.size())) != Z_OK)
+                {
+                    return false;
+                }
+
+                out.resize(deflateBound(&m_deflate, static_cast<uLong>(input.size())));
+                m_deflate.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+                m_deflate.avail_in = static_cast<uInt>(input.size());
+                m_deflate.next_out = reinterpret_cast<Bytef *>(out.data());
+                m_deflate.avail_out = static_cast<uInt>(out.size());
+                if (deflate(&m_deflate, Z_FINISH) != Z_STREAM_END)
+                {
+                    return false;
+                }
+                out.resize(m_deflate.total_out);
+                return true;
+            }
+
+#ifdef CAPTURE_HAVE_ZSTD
+            if (type == capture::Compression::Zstd)
+            {
+                if (!m_zstdCompress && !(m_zstdCompress = ZSTD_createCCtx()))
+                {
+                    return false;
+                }
+                out.resize(ZSTD_compressBound(input.size()));
+                size_t written = ZSTD_compress_usingDict(m_zstdCompress, out.data(), out.size(),
+                                                         input.data(), input.size(),
+                                                         dictionary.data(), dictionary.size(), m_level);
+                if (ZSTD_isError(written))
+                {
+                    return false;
+                }
+                out.resize(written);
+                return true;
+            }
+#endif
+            return false;
+        }
+
+        // Replaces out with exactly rawLength decompressed bytes
+        bool decompress(capture::Compression type, std::string_view input, size_t rawLength,
+                        std::string_view dictionary, std::string &out)
+        {
+            out.resize(rawLength);
+
+            if (type == capture::Compression::Zlib)
+            {
+                if (!m_inflateReady)
+                {
+                    m_inflate = {};
+                    m_inflateReady = inflateInit(&m_inflate) == Z_OK;
+                    if (!m_inflateReady)
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    inflateReset(&m_inflate);
+                }
+
+                m_inflate.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+                m_inflate.avail_in = static_cast<uInt>(input.size());
+                m_inflate.next_out = reinterpret_cast<Bytef *>(out.data());
+                m_inflate.avail_out = static_cast<uInt>(out.size());
+
+                int result = inflate(&m_inflate, Z_FINISH);
+                if (result == Z_NEED_DICT)
+                {
+                    if (dictionary.empty() ||
+                        inflateSetDictionary(&m_inflate, reinterpret_cast<const Bytef *>(dictionary.data()),
+                                             static_cast<uInt>(dictionary.size())) != Z_OK)
+                    {
+                        return false;
+                    }
+                    result = inflate(&m_inflate, Z_FINISH);
+                }
+                return result == Z_STREAM_END && m_inflate.total_out == rawLength;
+            }
+
+#ifdef CAPTURE_HAVE_ZSTD
+            if (type == capture::Compression::Zstd)
+            {
+                if (!m_zstdDecompress && !(m_zstdDecompress = ZSTD_createDCtx()))
+                {
+                    return false;
+                }
+                size_t written = ZSTD_decompress_usingDict(m_zstdDecompress, out.data(), out.size(),
+                                                           input.data(), input.size(),
+                                                           dictionary.data(), dictionary.size());
+                return !ZSTD_isError(written) && written == rawLength;
+            }
+#endif
+            return false;
+        }
+
+    private:
+        int m_level;
+        z_stream m_deflate{};
+        z_stream m_inflate{};
+        bool m_deflateReady = false;
+        bool m_inflateReady = false;
+#ifdef CAPTURE_HAVE_ZSTD
+        ZSTD_CCtx *m_zstdCompress = nullptr;
+        ZSTD_DCtx *m_zstdDecompress = nullptr;
+#endif
+    };
+
+    std::string_view CaptureDictionaries::find(const CaptureEntry &entry) const
+    {
+        // Direction, host and path; the query string usually differs per call
+        m_key.assign(1, static_cast<char>(entry.direction));
+        m_key += entry.host;
+        m_key.append(entry.endpoint, 0, entry.endpoint.find('?'));
+
+        auto it = m_dictionaries.find(m_key);
+        return it == m_dictionaries.end() ? std::string_view() : std::string_view(it->second);
+    }
+
+    void CaptureDictionaries::update(const CaptureEntry &entry, std::string_view payload)
+    {
+        if (payload.empty())
+        {
+            return;
+        }
+
+        find(entry);
+        auto it = m_dictionaries.find(m_key);
+        if (it == m_dictionaries.end())
+        {
+            if (m_dictionaries.size() >= MaxDictionaryEndpoints)
+            {
+                m_dictionaries.clear();
+            }
+            it = m_dictionaries.emplace(m_key, std::string()).first;
+        }
+        it->second.assign(payload.substr(payload.size() - std::min(payload.size(), MaxDictionaryBytes)));
+    }
+
+    CaptureStoreWriter::CaptureStoreWriter(std::string directory, const CaptureStoreOptions &options)
+        : m_directory(std::move(directory)), m_options(options)
+    {
+        m_buffer.reserve(m_options.bufferBytes + 4096);
+
+        if (m_options.compression != capture::Compression::None)
+        {
+            if (!CaptureCodec::supports(m_options.compression))
+            {
+                LOG_WARN("Capture compression {} is not built in, using zlib", static_cast<int>(m_options.compression));
+                m_options.compression = capture::Compression::Zlib;
+            }
+            m_codec = std::make_unique<CaptureCodec>(m_options.compressionLevel);
+        }
+
+        // Continue after the newest existing segment; an old one may end in a
+        // partial record and is never appended to
+        for (const std::string &segment : listCaptureSegments(m_directory))
+        {
+            m_sequence = std::max(m_sequence, segmentSequence(segment));
+        }
+    }
+
+    CaptureStoreWriter::~CaptureStoreWriter()
+    {
+        closeSegment();
+    }
+
+    bool CaptureStoreWriter::append(const CaptureEntry &entry)
+    {
+        if (!m_file.is_open() && !openSegment())
+        {
+            return false;
+        }
+
+        // Compress against the current segment's dictionary; if the record then
+        // starts a new segment it is compressed again without one
+        std::string_view payload = entry.payload;
+        uint32_t rawLength = static_cast<uint32_t>(entry.payload.size());
+        capture::Compression compression = capture::Compression::None;
+        uint8_t flags = 0;
+
+        auto compress = [&]() {
+            payload = entry.payload;
+            compression = capture::Compression::None;
+            flags = 0;
+            if (!m_codec || entry.payload.empty())
+            {
+                return;
+            }
+
+            std::string_view dictionary = m_dictionaries.find(entry);
+            // Incompressible payloads are stored as they are
+            if (m_codec->compress(m_options.compression, entry.payload, dictionary, m_compressed) &&
+                m_compressed.size() + sizeof(rawLength) < entry.payload.size())
+            {
+                payload = m_compressed;
+                compression = m_options.compression;
+                flags = dictionary.empty() ? 0 : capture::FlagDictionary;
+            }
+        };
+        compress();
+
+        uint32_t payloadLength = static_cast<uint32_t>(payload.size() +
+                                                       (compression != capture::Compression::None ? sizeof(rawLength) : 0));
+        uint64_t recordBytes = sizeof(uint32_t) + sizeof(capture::RecordHeader) + entry.host.size() +
+                               entry.endpoint.size() + entry.method.size() + payloadLength;
+
+        bool full = m_segmentSize > sizeof(capture::FileMagic) + sizeof(uint32_t) &&
+                    m_segmentSize + recordBytes > m_options.segmentBytes;
+        if (full)
+        {
+            closeSegment();
+            if (!openSegment())
+            {
+                return false;
+            }
+            if (flags & capture::FlagDictionary)
+            {
+                compress();
+                payloadLength = static_cast<uint32_t>(payload.size() +
+                                                      (compression != capture::Compression::None ? sizeof(rawLength) : 0));
+                recordBytes = sizeof(uint32_t) + sizeof(capture::RecordHeader) + entry.host.size() +
+                              entry.endpoint.size() + entry.method.size() + payloadLength;
+            }
+        }
+
+        capture::RecordHeader header{};
+        header.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(entry.time.time_since_epoch()).count();
+        header.payloadLength = payloadLength;
+        header.responseCode = entry.responseCode;
+        header.hostLength = static_cast<uint32_t>(entry.host.size());
+        header.endpointLength = static_cast<uint32_t>(entry.endpoint.size());
+        header.methodLength = static_cast<uint32_t>(entry.method.size());
+        header.direction = static_cast<uint8_t>(entry.direction);
+        header.payloadFormat = static_cast<uint8_t>(entry.payloadFormat);
+        header.compression = static_cast<uint8_t>(compression);
+        header.flags = flags;
+
+        uint32_t size = static_cast<uint32_t>(recordBytes - sizeof(uint32_t));
+        appendRaw(m_buffer, size);
+        appendRaw(m_buffer, header);
+        m_buffer.append(entry.host);
+        m_buffer.append(entry.endpoint);
+        m_buffer.append(entry.method);
+        if (compression != capture::Compression::None)
+        {
+            appendRaw(m_buffer, rawLength);
+        }
+        m_buffer.append(payload);
+        m_segmentSize += recordBytes;
+
+        m_payloadBytes += entry.payload.size();
+        m_storedPayloadBytes += payloadLength;
+        if (m_codec)
+        {
+            m_dictionaries.update(entry, entry.payload);
+        }
+
+        if (m_buffer.size() >= m_options.bufferBytes)
+        {
+            flush();
+        }
+        return true;
+    }
+
+    void CaptureStoreWriter::flush()
+    {
+        if (m_buffer.empty() || !m_file.is_open())
+        {
+            return;
+        }
+
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_file.flush();
+        m_buffer.clear();
+    }
+
+    bool CaptureStoreWriter::openSegment()
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+
+        m_segmentPath = (std::filesystem::path(m_directory) /
+                         std::format("{}{:06}{}", SegmentPrefix, ++m_sequence, capture::SegmentExtension))
+                            .string();
+        m_file.open(m_segmentPath, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open())
+        {
+            LOG_ERROR("Failed to open capture segment: {}", m_segmentPath);
+            return false;
+        }
+
+        m_buffer.append(capture::FileMagic, sizeof(capture::FileMagic));
+        appendRaw(m_buffer, capture::FileVersion);
+        m_segmentSize = m_buffer.size();
+        m_dictionaries.clear();
+
+        applyRetention();
+        return true;
+    }
+
+    void CaptureStoreWriter::applyRetention()
+    {
+        if (m_options.retentionBytes == 0 && m_options.retentionAge.count() == 0)
+        {
+            return;
+        }
+
+        struct Segment
+        {
+            std::string path;
+            uint64_t size;
+            std::filesystem::file_time_type modified;
+        };
+
+        std::vector<Segment> segments;
+        uint64_t total = 0;
+        std::error_code ec;
+        for (std::string &path : listCaptureSegments(m_directory))
+        {
+            if (path == m_segmentPath)
+            {
+                continue;
+            }
+            uint64_t size = std::filesystem::file_size(path, ec);
+            auto modified = std::filesystem::last_write_time(path, ec);
+            if (ec)
+            {
+                continue;
+            }
+            total += size;
+            segments.push_back({std::move(path), size, modified});
+        }
+
+        auto now = std::filesystem::file_time_type::clock::now();
+        for (const Segment &segment : segments)
+        {
+            bool overSize = m_options.retentionBytes > 0 && total > m_options.retentionBytes;
+            bool overAge = m_options.retentionAge.count() > 0 && now - segment.modified > m_options.retentionAge;
+            if (!overSize && !overAge)
+            {
+                // Oldest first, so everything after this is kept too
+                break;
+            }
+
+            if (std::filesystem::remove(segment.path, ec))
+            {
+                total -= segment.size;
+                LOG_INFO("Capture retention removed {} ({} bytes)", segment.path, segment.size);
+            }
+        }
+    }
+
+    void CaptureStoreWriter::closeSegment()
+    {
+        if (!m_file.is_open())
+        {
+            return;
+        }
+
+        flush();
+        m_file.close();
+    }
+
+    std::vector<std::string> listCaptureSegments(const std::string &directory)
+    {
+        std::vector<std::pair<uint32_t, std::string>> segments;
+        std::error_code ec;
+        for (const auto &file : std::filesystem::directory_iterator(directory, ec))
+        {
+            if (uint32_t sequence = segmentSequence(file.path()))
+            {
+                segments.emplace_back(sequence, file.path().string());
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+
+        std::vector<std::string> result;
+        result.reserve(segments.size());
+        for (auto &segment : segments)
+        {
+            result.push_back(std::move(segment.second));
+        }
+        return result;
+    }
+
+    CaptureSegmentReader::CaptureSegmentReader(const std::string &path)
+        : m_file(path, std::ios::binary), m_codec(std::make_unique<CaptureCodec>(0))
+    {
+        char magic[sizeof(capture::FileMagic)];
+        uint32_t version = 0;
+        m_valid = m_file.read(magic, sizeof(magic)) &&
+                  std::memcmp(magic, capture::FileMagic, sizeof(magic)) == 0 &&
+                  m_file.read(reinterpret_cast<char *>(&version), sizeof(version)) &&
+                  version == capture::FileVersion;
+    }
+
+    CaptureSegmentReader::~CaptureSegmentReader() = default;
+
+    bool CaptureSegmentReader::next(CaptureEntry &entry)
+    {
+        if (!m_valid || m_truncated || m_corrupt)
+        {
+            return false;
+        }
+
+        uint32_t size = 0;
+        if (!m_file.read(reinterpret_cast<char *>(&size), sizeof(size)))
+        {
+            // A clean end of segment reads nothing at all
+            m_truncated = m_file.gcount() != 0;
+            return false;
+        }
+
+        capture::RecordHeader header;
+        if (size < sizeof(header) || !m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            uint64_t(sizeof(header)) + header.hostLength + header.endpointLength + header.methodLength +
+                    header.payloadLength != size)
+        {
+            m_truncated = true;
+            return false;
+        }
+
+        auto readString = [this](std::string &out, uint32_t length) {
+            out.resize(length);
+            return length == 0 || static_cast<bool>(m_file.read(out.data(), length));
+        };
+        auto compression = static_cast<capture::Compression>(header.compression);
+        bool compressed = compression != capture::Compression::None;
+        if (!readString(entry.host, header.hostLength) ||
+            !readString(entry.endpoint, header.endpointLength) ||
+            !readString(entry.method, header.methodLength) ||
+            !readString(compressed ? m_compressed : entry.payload, header.payloadLength))
+        {
+            m_truncated = true;
+            return false;
+        }
+
+        entry.direction = static_cast<capture::Direction>(header.direction);
+        if (compressed)
+        {
+            uint32_t rawLength = 0;
+            std::string_view dictionary;
+            if (header.flags & capture::FlagDictionary)
+            {
+                dictionary = m_dictionaries.find(entry);
+            }
+            if (m_compressed.size() < sizeof(rawLength) || !CaptureCodec::supports(compression))
+            {
+                m_corrupt = true;
+                return false;
+            }
+
+            std::memcpy(&rawLength, m_compressed.data(), sizeof(rawLength));
+            if (!m_codec->decompress(compression, std::string_view(m_compressed).substr(sizeof(rawLength)),
+                                     rawLength, dictionary, entry.payload))
+            {
+                m_corrupt = true;
+                return false;
+            }
+        }
+        m_dictionaries.update(entry, entry.payload);
+
+        entry.time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(header.timestampNs)));
+        entry.responseCode = header.responseCode;
+        entry.payloadFormat = static_cast<capture::PayloadFormat>(header.payloadFormat);
+        return true;
+    }
+
+}
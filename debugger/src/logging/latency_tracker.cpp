@@ -0,0 +1,283 @@
+#include <logging/latency_tracker.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <vector>
+
+namespace core::logging
+{
+
+    namespace
+    {
+        // Pending requests kept per client and endpoint; beyond this the oldest
+        // is dropped (a response for it would be matched to a later request)
+        constexpr size_t MaxPendingPerClient = 256;
+
+        std::string formatMicros(uint64_t micros)
+        {
+            if (micros >= 1000000)
+            {
+                return std::format("{:.2f}s", micros / 1e6);
+            }
+            if (micros >= 1000)
+            {
+                return std::format("{:.1f}ms", micros / 1e3);
+            }
+            return std::format("{}us", micros);
+        }
+    }
+
+    size_t LatencyHistogram::bucketIndex(uint64_t value)
+    {
+        // Values below 2 * SubBuckets map to themselves; above that, each power
+        // of two gets SubBuckets buckets
+        uint32_t msb = static_cast<uint32_t>(std::bit_width(value | 1)) - 1;
+        uint32_t shift = msb > SubBucketBits ? msb - SubBucketBits : 0;
+        return static_cast<size_t>(shift * SubBuckets + (value >> shift));
+    }
+
+    uint64_t LatencyHistogram::bucketHighest(size_t index)
+    {
+        if (index < 2 * SubBuckets)
+        {
+            return index;
+        }
+        uint64_t shift = index / SubBuckets - 1;
+        uint64_t mantissa = index - shift * SubBuckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t value)
+    {
+        value = std::min(value, MaxValue);
+        ++m_buckets[bucketIndex(value)];
+        ++m_count;
+        m_sum += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void LatencyHistogram::addToBucket(size_t index, uint64_t count)
+    {
+        if (count == 0 || index >= BucketCount)
+        {
+            return;
+        }
+        uint64_t value = bucketHighest(index);
+        m_buckets[index] += count;
+        m_count += count;
+        m_sum += value * count;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t LatencyHistogram::percentile(double q) const
+    {
+        if (m_count == 0)
+        {
+            return 0;
+        }
+
+        uint64_t target = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(m_count)));
+        target = std::clamp<uint64_t>(target, 1, m_count);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= target)
+            {
+                return std::min(bucketHighest(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    LatencyTracker::LatencyTracker(std::chrono::seconds timeout)
+        : m_timeout(timeout), m_started(Clock::now())
+    {
+    }
+
+    std::string_view LatencyTracker::endpointPath(std::string_view endpointOrUrl)
+    {
+        std::string_view path = endpointOrUrl;
+        size_t scheme = path.find("://");
+        if (scheme != std::string_view::npos)
+        {
+            size_t start = path.find('/', scheme + 3);
+            path = start == std::string_view::npos ? std::string_view() : path.substr(start);
+        }
+        // Relative endpoints are not always written with a leading slash
+        if (path.starts_with('/'))
+        {
+            path.remove_prefix(1);
+        }
+        return path.substr(0, path.find('?'));
+    }
+
+    LatencyTracker::EndpointStats &LatencyTracker::endpoint(std::string_view path)
+    {
+        auto it = m_endpoints.find(path);
+        if (it == m_endpoints.end())
+        {
+            it = m_endpoints.emplace(std::string(path), EndpointStats{}).first;
+        }
+        return it->second;
+    }
+
+    void LatencyTracker::onRequest(const void *client, std::string_view endpointOrUrl, Clock::time_point time)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::deque<Clock::time_point> &pending = endpoint(endpointPath(endpointOrUrl)).pending[client];
+        if (pending.size() >= MaxPendingPerClient)
+        {
+            pending.pop_front();
+        }
+        pending.push_back(time);
+    }
+
+    void LatencyTracker::onResponse(const void *client, std::string_view url, int32_t responseCode, Clock::time_point time)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EndpointStats &stats = endpoint(endpointPath(url));
+        ++stats.responseCodes[responseCode];
+
+        auto pending = stats.pending.find(client);
+        if (pending == stats.pending.end())
+        {
+            ++stats.unmatched;
+            return;
+        }
+
+        // Requests that never got an answer would otherwise pair with every later response
+        std::deque<Clock::time_point> &queue = pending->second;
+        while (!queue.empty() && time - queue.front() > m_timeout)
+        {
+            queue.pop_front();
+            ++stats.expired;
+        }
+
+        if (queue.empty())
+        {
+            ++stats.unmatched;
+            return;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - queue.front());
+        queue.pop_front();
+        stats.latency.record(static_cast<uint64_t>(std::max<int64_t>(elapsed.count(), 0)));
+    }
+
+    std::string LatencyTracker::report() const
+    {
+        struct Row
+        {
+            std::string path;
+            LatencyHistogram latency;
+            std::map<int32_t, uint64_t> responseCodes;
+            uint64_t unmatched;
+            uint64_t expired;
+            size_t pending;
+        };
+
+        // Copy under the lock and format outside it, so hooks are not held up
+        std::vector<Row> rows;
+        Clock::time_point started;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            started = m_started;
+            rows.reserve(m_endpoints.size());
+            for (const auto &[path, stats] : m_endpoints)
+            {
+                size_t pending = 0;
+                for (const auto &[client, queue] : stats.pending)
+                {
+                    pending += queue.size();
+                }
+                rows.push_back({path, stats.latency, stats.responseCodes, stats.unmatched, stats.expired, pending});
+            }
+        }
+
+        std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+            return a.latency.count() != b.latency.count() ? a.latency.count() > b.latency.count() : a.path < b.path;
+        });
+
+        auto uptime = std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - started);
+        std::string out = std::format("# Hydra round-trip latency, {} endpoints, {}s of traffic\n", rows.size(), uptime.count());
+        out += std::format("{:<60} {:>8} {:>9} {:>9} {:>9} {:>9} {:>9} {:>8} {:>8} {:>8}\n",
+                           "endpoint", "count", "p50", "p99", "p999", "max", "mean", "pending", "unmatch", "expired");
+
+        for (const Row &row : rows)
+        {
+            const LatencyHistogram &h = row.latency;
+            out += std::format("{:<60} {:>8} {:>9} {:>9} {:>9} {:>9} {:>9} {:>8} {:>8} {:>8}\n",
+                               row.path, h.count(),
+                               formatMicros(h.percentile(0.50)), formatMicros(h.percentile(0.99)),
+                               formatMicros(h.percentile(0.999)), formatMicros(h.max()),
+                               formatMicros(static_cast<uint64_t>(h.mean())),
+                               row.pending, row.unmatched, row.expired);
+
+            std::string codes;
+            for (const auto &[code, count] : row.responseCodes)
+            {
+                codes += std::format(" {}x{}", code, count);
+            }
+            if (!codes.empty())
+            {
+                out += std::format("    codes:{}\n", codes);
+            }
+        }
+        return out;
+    }
+
+    bool LatencyTracker::writeReport(const std::string &path) const
+    {
+        std::error_code ec;
+        std::filesystem::path target(path);
+        if (target.has_parent_path())
+        {
+            std::filesystem::create_directories(target.parent_path(), ec);
+        }
+
+        std::filesystem::path temporary = target;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+            file << report();
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, target, ec);
+        return !ec;
+    }
+
+    void LatencyTracker::reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_endpoints.clear();
+        m_started = Clock::now();
+    }
+
+}
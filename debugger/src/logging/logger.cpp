@@ -1,5 +1,8 @@
 #include <logging/logger.hpp>
-#include <iostream>
+#include <logging/ring_buffer.hpp>
+#include <logging/sinks.hpp>
+#include <algorithm>
+#include <iterator>
 #include <mutex>
 
 #ifdef _WIN32
@@ -34,112 +37,282 @@ namespace core::logging
 #endif
             return true;
         }
+    }
 
-        namespace Color
+    std::string_view getLevelString(LogLevel level)
+    {
+        switch (level)
         {
-            constexpr std::string_view Reset = "\033[0m";
-            constexpr std::string_view Grey = "\033[38;2;150;150;150m";   // RGB grey
-            constexpr std::string_view White = "\033[38;2;220;220;220m";  // Soft white
-            constexpr std::string_view Green = "\033[38;2;100;200;100m";  // Softer green
-            constexpr std::string_view Yellow = "\033[38;2;220;180;50m";  // Warm yellow
-            constexpr std::string_view Red = "\033[38;2;220;100;100m";    // Soft red
-            constexpr std::string_view Purple = "\033[38;2;180;100;180m"; // Soft purple
+        case LogLevel::Trace:
+            return "TRACE";
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO "; // Padding for alignment
+        case LogLevel::Warning:
+            return "WARN "; // Padding for alignment
+        case LogLevel::Error:
+            return "ERROR";
+        case LogLevel::Fatal:
+            return "FATAL";
+        default:
+            return "?????";
+        }
+    }
+
+    std::string_view getFileName(std::string_view path)
+    {
+        size_t pos = path.find_last_of("/\\");
+        return pos == std::string_view::npos ? path : path.substr(pos + 1);
+    }
 
-            constexpr std::string_view ErrorBg = "\033[48;2;40;0;0m";  // Dark red background
-            constexpr std::string_view FatalBg = "\033[48;2;60;0;60m"; // Dark purple background
+    Logger &getLogger()
+    {
+        static Logger instance;
+        static bool initialized = initializeConsole();
+        return instance;
+    }
 
-            static const std::string ErrorStyle = std::string(Red) + std::string(ErrorBg);
-            static const std::string FatalStyle = std::string(Purple) + std::string(FatalBg);
+    Logger::Logger()
+    {
+        m_sinks.push_back(std::make_shared<ConsoleSink>());
+        updateLevelFloor();
+    }
+
+    Logger::~Logger()
+    {
+        stopAsync();
+    }
+
+    void Logger::startAsync(const AsyncOptions &options)
+    {
+        std::lock_guard<std::mutex> control(m_controlMutex);
+        if (m_running.load(std::memory_order_acquire))
+        {
+            return;
         }
 
-        std::string_view getLevelColor(LogLevel level)
+        // The queue is never replaced while the logger lives, so a producer that
+        // raced with stopAsync() still pushes into valid memory
+        if (!m_queue)
         {
-            switch (level)
-            {
-            case LogLevel::Trace:
-                return Color::Grey;
-            case LogLevel::Debug:
-                return Color::White;
-            case LogLevel::Info:
-                return Color::Green;
-            case LogLevel::Warning:
-                return Color::Yellow;
-            case LogLevel::Error:
-                return Color::ErrorStyle;
-            case LogLevel::Fatal:
-                return Color::FatalStyle;
-            default:
-                return Color::White;
-            }
+            m_queue = std::make_unique<MpscRingBuffer<LogRecord>>(options.capacity);
         }
+        m_overflow = options.overflow;
+
+        m_running.store(true, std::memory_order_release);
+        m_consumer = std::thread(&Logger::consumerLoop, this);
+        m_async.store(true, std::memory_order_release);
+    }
 
-        std::string_view getLevelString(LogLevel level)
+    void Logger::stopAsync()
+    {
+        std::lock_guard<std::mutex> control(m_controlMutex);
+        if (!m_running.load(std::memory_order_acquire))
         {
-            switch (level)
-            {
-            case LogLevel::Trace:
-                return "TRACE";
-            case LogLevel::Debug:
-                return "DEBUG";
-            case LogLevel::Info:
-                return "INFO "; // Padding for alignment
-            case LogLevel::Warning:
-                return "WARN "; // Padding for alignment
-            case LogLevel::Error:
-                return "ERROR";
-            case LogLevel::Fatal:
-                return "FATAL";
-            default:
-                return "?????";
-            }
+            return;
+        }
+
+        m_async.store(false, std::memory_order_release);
+        m_running.store(false, std::memory_order_release);
+        wakeConsumer();
+        if (m_consumer.joinable())
+        {
+            m_consumer.join();
         }
 
-        std::string_view getFileName(std::string_view path)
+        // Anything pushed between the consumer's last drain and now
+        LogRecord record;
+        while (m_queue->tryPop(record))
         {
-            size_t pos = path.find_last_of("/\\");
-            return pos == std::string_view::npos ? path : path.substr(pos + 1);
+            writeRecord(record);
         }
+        flush();
     }
 
-    Logger &getLogger()
+    void Logger::addSink(std::shared_ptr<Sink> sink)
     {
-        static Logger instance;
-        static bool initialized = initializeConsole();
-        return instance;
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_sinks.push_back(std::move(sink));
+        updateLevelFloor();
+    }
+
+    void Logger::removeSink(const std::shared_ptr<Sink> &sink)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        sink->flush();
+        std::erase(m_sinks, sink);
+        updateLevelFloor();
+    }
+
+    void Logger::clearSinks()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        for (const auto &sink : m_sinks)
+        {
+            sink->flush();
+        }
+        m_sinks.clear();
+        updateLevelFloor();
+    }
+
+    void Logger::flush()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        for (const auto &sink : m_sinks)
+        {
+            sink->flush();
+        }
+    }
+
+    void Logger::setMinLevel(LogLevel level)
+    {
+        Logger &logger = getLogger();
+        std::lock_guard<std::mutex> lock(logger.m_writeMutex);
+        logger.m_minLevel.store(level, std::memory_order_relaxed);
+        logger.updateLevelFloor();
+    }
+
+    void Logger::updateLevelFloor()
+    {
+        // Nothing below the lowest sink threshold can reach any output
+        LogLevel floor = LogLevel::Fatal;
+        for (const auto &sink : m_sinks)
+        {
+            floor = std::min(floor, sink->threshold());
+        }
+        floor = std::max(floor, m_minLevel.load(std::memory_order_relaxed));
+        s_levelFloor.store(static_cast<int>(floor), std::memory_order_relaxed);
     }
 
     void Logger::logImpl(LogLevel level,
-                         const std::string &message,
+                         std::string &&message,
                          const std::source_location &loc)
     {
-        static std::mutex logMutex;
-        std::lock_guard<std::mutex> lock(logMutex);
+        submit(LogRecord{level, loc, std::chrono::system_clock::now(), std::move(message)});
+    }
 
-        auto now = std::chrono::system_clock::now();
-        auto timeT = std::chrono::system_clock::to_time_t(now);
-        std::tm timeInfo;
-#ifdef _WIN32
-        localtime_s(&timeInfo, &timeT);
-#else
-        localtime_r(&timeT, &timeInfo);
-#endif
+    void Logger::submit(LogRecord &&record)
+    {
+        if (m_async.load(std::memory_order_acquire))
+        {
+            enqueue(std::move(record));
+            return;
+        }
+
+        writeRecord(record);
+    }
+
+    void Logger::enqueue(LogRecord &&record)
+    {
+        while (!m_queue->tryPush(std::move(record)))
+        {
+            switch (m_overflow)
+            {
+            case OverflowPolicy::DropNewest:
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+
+            case OverflowPolicy::DropOldest:
+            {
+                LogRecord oldest;
+                if (m_queue->tryPop(oldest))
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+
+            case OverflowPolicy::Block:
+                if (!m_running.load(std::memory_order_acquire))
+                {
+                    // No consumer left to make room
+                    writeRecord(record);
+                    return;
+                }
+                wakeConsumer();
+                std::this_thread::yield();
+                break;
+            }
+        }
+
+        // Pairs with the fence in consumerLoop: either the consumer sees this
+        // record on its re-check, or we see it idle and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_consumerIdle.load(std::memory_order_relaxed))
+        {
+            wakeConsumer();
+        }
+    }
+
+    void Logger::wakeConsumer()
+    {
+        m_wakeups.fetch_add(1, std::memory_order_release);
+        m_wakeups.notify_one();
+    }
+
+    void Logger::consumerLoop()
+    {
+        LogRecord record;
+        for (;;)
+        {
+            bool wrote = false;
+            while (m_queue->tryPop(record))
+            {
+                writeRecord(record);
+                wrote = true;
+            }
+
+            // One write per sink for the whole drained batch
+            if (wrote)
+            {
+                flush();
+            }
+
+            if (!m_running.load(std::memory_order_acquire))
+            {
+                return;
+            }
 
-        char timeBuffer[16];
-        std::strftime(timeBuffer, sizeof(timeBuffer), "%H:%M:%S", &timeInfo);
+            uint32_t ticket = m_wakeups.load(std::memory_order_acquire);
+            m_consumerIdle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_queue->empty() && m_running.load(std::memory_order_acquire))
+            {
+                m_wakeups.wait(ticket, std::memory_order_acquire);
+            }
+            m_consumerIdle.store(false, std::memory_order_relaxed);
+        }
+    }
 
-        // [filename:line] HH:MM:SS LEVEL message
-        std::cout << std::format("{}[{}:{}] {} [{}] {}{}\n",
-                                 getLevelColor(level),
-                                 getFileName(loc.file_name()),
-                                 loc.line(),
-                                 timeBuffer,
-                                 getLevelString(level),
-                                 message,
-                                 Color::Reset);
+    void Logger::writeRecord(const LogRecord &record)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        // [filename:line] HH:MM:SS LEVEL message, rendered once for every sink
+        m_line.clear();
+        std::format_to(std::back_inserter(m_line), "[{}:{}] {} [{}] {}",
+                       getFileName(record.loc.file_name()),
+                       record.loc.line(),
+                       m_timestamps.format(record.time),
+                       getLevelString(record.level),
+                       record.message);
 
-        if (level >= LogLevel::Warning)
+        for (const auto &sink : m_sinks)
         {
-            std::cout.flush();
+            if (sink->accepts(record.level))
+            {
+                sink->append(record.level, m_line);
+            }
+        }
+
+        // The consumer flushes once per drained batch instead
+        if (!m_async.load(std::memory_order_relaxed))
+        {
+            for (const auto &sink : m_sinks)
+            {
+                sink->flush();
+            }
         }
     }
 
@@ -0,0 +1,246 @@
+#include <logging/overhead_monitor.hpp>
+#include <logging/logger.hpp>
+#include <algorithm>
+#include <format>
+#include <thread>
+
+namespace core::logging
+{
+
+    namespace
+    {
+        std::atomic<uint64_t> s_nextMonitorId{1};
+
+        std::string formatNanos(uint64_t nanos)
+        {
+            return std::format("{:.1f}us", nanos / 1e3);
+        }
+    }
+
+    // One hook thread's counts. Only the owning thread writes buckets; collect()
+    // reads them and remembers what it has already folded in seen.
+    struct OverheadMonitor::ThreadHistograms
+    {
+        using Buckets = std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount>;
+
+        std::thread::id owner;
+        std::array<Buckets, PhaseCount> buckets{};
+        std::array<std::array<uint64_t, LatencyHistogram::BucketCount>, PhaseCount> seen{};
+    };
+
+    OverheadMonitor::OverheadMonitor() : OverheadMonitor(Options())
+    {
+    }
+
+    OverheadMonitor::OverheadMonitor(const Options &options)
+        : m_id(s_nextMonitorId.fetch_add(1, std::memory_order_relaxed)), m_options(options)
+    {
+        m_options.windowIntervals = std::max<size_t>(m_options.windowIntervals, 1);
+    }
+
+    OverheadMonitor::~OverheadMonitor() = default;
+
+    void OverheadMonitor::setOptions(const Options &options)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+        m_options.windowIntervals = std::max<size_t>(m_options.windowIntervals, 1);
+    }
+
+    OverheadMonitor::ThreadHistograms &OverheadMonitor::local()
+    {
+        struct Cached
+        {
+            uint64_t monitor = 0;
+            ThreadHistograms *slot = nullptr;
+        };
+        thread_local Cached cached;
+
+        if (cached.monitor == m_id)
+        {
+            return *cached.slot;
+        }
+
+        // First record from this thread, or it last recorded into another monitor
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::thread::id self = std::this_thread::get_id();
+        auto it = std::find_if(m_threads.begin(), m_threads.end(),
+                               [&](const auto &slot) { return slot->owner == self; });
+        if (it == m_threads.end())
+        {
+            m_threads.push_back(std::make_unique<ThreadHistograms>());
+            m_threads.back()->owner = self;
+            it = std::prev(m_threads.end());
+        }
+        cached = {m_id, it->get()};
+        return *cached.slot;
+    }
+
+    void OverheadMonitor::record(Phase phase, Clock::duration elapsed)
+    {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        uint64_t value = std::min<uint64_t>(static_cast<uint64_t>(std::max<int64_t>(nanos, 0)), LatencyHistogram::MaxValue);
+
+        // Single writer: a plain load and store, no locked increment
+        std::atomic<uint64_t> &bucket = local().buckets[static_cast<size_t>(phase)][LatencyHistogram::bucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void OverheadMonitor::collectLocked()
+    {
+        auto interval = std::make_unique<Interval>();
+        for (const auto &slot : m_threads)
+        {
+            for (size_t phase = 0; phase < PhaseCount; ++phase)
+            {
+                for (size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+                {
+                    uint64_t now = slot->buckets[phase][i].load(std::memory_order_relaxed);
+                    uint64_t &seen = slot->seen[phase][i];
+                    if (now != seen)
+                    {
+                        (*interval)[phase].addToBucket(i, now - seen);
+                        seen = now;
+                    }
+                }
+            }
+        }
+
+        m_window.push_back(std::move(interval));
+        while (m_window.size() > m_options.windowIntervals)
+        {
+            m_window.pop_front();
+        }
+    }
+
+    void OverheadMonitor::collect()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        collectLocked();
+    }
+
+    LatencyHistogram OverheadMonitor::windowed(Phase phase) const
+    {
+        LatencyHistogram result;
+        for (const auto &interval : m_window)
+        {
+            result.merge((*interval)[static_cast<size_t>(phase)]);
+        }
+        return result;
+    }
+
+    void OverheadMonitor::evaluate()
+    {
+        Verbosity from = verbosity();
+        Verbosity to = from;
+        uint64_t p99 = 0;
+        uint64_t budget = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            collectLocked();
+
+            // Let the window fill with calls made at the current verbosity
+            if (m_holdOff > 0)
+            {
+                --m_holdOff;
+                return;
+            }
+
+            LatencyHistogram total = windowed(Phase::Total);
+            if (total.count() < m_options.minSamples)
+            {
+                return;
+            }
+
+            p99 = total.percentile(0.99);
+            budget = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_options.budget).count());
+            if (p99 > budget && from != Verbosity::Counters)
+            {
+                to = static_cast<Verbosity>(static_cast<uint8_t>(from) + 1);
+            }
+            else if (p99 < budget / 2 && from != Verbosity::Full)
+            {
+                to = static_cast<Verbosity>(static_cast<uint8_t>(from) - 1);
+            }
+
+            if (to == from)
+            {
+                return;
+            }
+            m_verbosity.store(to, std::memory_order_relaxed);
+            m_window.clear();
+            m_holdOff = m_options.windowIntervals;
+        }
+
+        uint64_t suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        if (to > from)
+        {
+            LOG_WARN("Hook overhead p99 {} over budget {}: verbosity {} -> {}",
+                     formatNanos(p99), formatNanos(budget), verbosityName(from), verbosityName(to));
+        }
+        else
+        {
+            LOG_INFO("Hook overhead p99 {} under half of budget {}: verbosity {} -> {} ({} calls had no output)",
+                     formatNanos(p99), formatNanos(budget), verbosityName(from), verbosityName(to), suppressed);
+        }
+    }
+
+    std::string OverheadMonitor::report() const
+    {
+        std::array<LatencyHistogram, PhaseCount> phases;
+        size_t intervals;
+        Options options;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t phase = 0; phase < PhaseCount; ++phase)
+            {
+                phases[phase] = windowed(static_cast<Phase>(phase));
+            }
+            intervals = m_window.size();
+            options = m_options;
+        }
+
+        std::string out = std::format("Hook overhead over {} intervals, verbosity {}, p99 budget {}us\n",
+                                      intervals, verbosityName(verbosity()), options.budget.count());
+        out += std::format("  {:<9} {:>9} {:>10} {:>10} {:>10}\n", "phase", "count", "p50", "p99", "max");
+        for (size_t phase = 0; phase < PhaseCount; ++phase)
+        {
+            const LatencyHistogram &h = phases[phase];
+            out += std::format("  {:<9} {:>9} {:>10} {:>10} {:>10}\n",
+                               phaseName(static_cast<Phase>(phase)), h.count(),
+                               formatNanos(h.percentile(0.50)), formatNanos(h.percentile(0.99)), formatNanos(h.max()));
+        }
+        return out;
+    }
+
+    std::string_view OverheadMonitor::phaseName(Phase phase)
+    {
+        switch (phase)
+        {
+        case Phase::Print:
+            return "print";
+        case Phase::Snapshot:
+            return "snapshot";
+        case Phase::Capture:
+            return "capture";
+        case Phase::Total:
+            return "total";
+        }
+        return "unknown";
+    }
+
+    std::string_view OverheadMonitor::verbosityName(Verbosity verbosity)
+    {
+        switch (verbosity)
+        {
+        case Verbosity::Full:
+            return "full";
+        case Verbosity::Summary:
+            return "summary";
+        case Verbosity::Counters:
+            return "counters";
+        }
+        return "unknown";
+    }
+
+}
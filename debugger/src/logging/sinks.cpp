@@ -0,0 +1,298 @@
+#include <logging/sinks.hpp>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace core::logging
+{
+
+    namespace
+    {
+        namespace Color
+        {
+            constexpr std::string_view Reset = "\033[0m";
+            constexpr std::string_view Grey = "\033[38;2;150;150;150m";   // RGB grey
+            constexpr std::string_view White = "\033[38;2;220;220;220m";  // Soft white
+            constexpr std::string_view Green = "\033[38;2;100;200;100m";  // Softer green
+            constexpr std::string_view Yellow = "\033[38;2;220;180;50m";  // Warm yellow
+            constexpr std::string_view Red = "\033[38;2;220;100;100m";    // Soft red
+            constexpr std::string_view Purple = "\033[38;2;180;100;180m"; // Soft purple
+
+            constexpr std::string_view ErrorBg = "\033[48;2;40;0;0m";  // Dark red background
+            constexpr std::string_view FatalBg = "\033[48;2;60;0;60m"; // Dark purple background
+
+            static const std::string ErrorStyle = std::string(Red) + std::string(ErrorBg);
+            static const std::string FatalStyle = std::string(Purple) + std::string(FatalBg);
+        }
+
+        std::string_view getLevelColor(LogLevel level)
+        {
+            switch (level)
+            {
+            case LogLevel::Trace:
+                return Color::Grey;
+            case LogLevel::Debug:
+                return Color::White;
+            case LogLevel::Info:
+                return Color::Green;
+            case LogLevel::Warning:
+                return Color::Yellow;
+            case LogLevel::Error:
+                return Color::ErrorStyle;
+            case LogLevel::Fatal:
+                return Color::FatalStyle;
+            default:
+                return Color::White;
+            }
+        }
+
+        // Loops until everything is written; short writes are retried, not split into batches
+        bool writeAll(intptr_t handle, std::string_view data)
+        {
+            while (!data.empty())
+            {
+#ifdef _WIN32
+                DWORD written = 0;
+                if (!WriteFile(reinterpret_cast<HANDLE>(handle), data.data(), static_cast<DWORD>(data.size()), &written, nullptr))
+                {
+                    return false;
+                }
+#else
+                ssize_t written = ::write(static_cast<int>(handle), data.data(), data.size());
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+#endif
+                data.remove_prefix(static_cast<size_t>(written));
+            }
+            return true;
+        }
+    }
+
+    BufferedSink::BufferedSink(LogLevel threshold, size_t batchBytes)
+        : Sink(threshold), m_batchBytes(batchBytes)
+    {
+        m_batch.reserve(batchBytes + 1024);
+    }
+
+    void BufferedSink::appendLine(std::string_view prefix, std::string_view line, std::string_view suffix)
+    {
+        m_batch.append(prefix);
+        m_batch.append(line);
+        m_batch.append(suffix);
+        m_batch.push_back('\n');
+
+        if (m_batch.size() >= m_batchBytes)
+        {
+            flush();
+        }
+    }
+
+    void BufferedSink::flush()
+    {
+        if (m_batch.empty())
+        {
+            return;
+        }
+
+        // On failure the batch is discarded; logging must never back up the caller
+        writeBatch(m_batch);
+        m_batch.clear();
+    }
+
+    ConsoleSink::ConsoleSink(LogLevel threshold, bool colors, size_t batchBytes)
+        : BufferedSink(threshold, batchBytes), m_colors(colors)
+    {
+    }
+
+    void ConsoleSink::append(LogLevel level, std::string_view line)
+    {
+        if (m_colors)
+        {
+            appendLine(getLevelColor(level), line, Color::Reset);
+        }
+        else
+        {
+            appendLine({}, line, {});
+        }
+    }
+
+    bool ConsoleSink::writeBatch(std::string_view data)
+    {
+#ifdef _WIN32
+        // Looked up per batch: the console is allocated after the logger exists
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (!console || console == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        return writeAll(reinterpret_cast<intptr_t>(console), data);
+#else
+        return writeAll(STDOUT_FILENO, data);
+#endif
+    }
+
+    FileSink::FileSink(std::string path, LogLevel threshold, size_t batchBytes)
+        : BufferedSink(threshold, batchBytes), m_path(std::move(path))
+    {
+        openFile(false);
+    }
+
+    FileSink::~FileSink()
+    {
+        closeFile();
+    }
+
+    void FileSink::append(LogLevel, std::string_view line)
+    {
+        appendLine({}, line, {});
+    }
+
+    bool FileSink::openFile(bool truncate)
+    {
+        std::error_code ec;
+        std::filesystem::path parent = std::filesystem::path(m_path).parent_path();
+        if (!parent.empty())
+        {
+            std::filesystem::create_directories(parent, ec);
+        }
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(m_path.c_str(),
+                                  FILE_APPEND_DATA,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr,
+                                  truncate ? CREATE_ALWAYS : OPEN_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+        m_handle = file == INVALID_HANDLE_VALUE ? InvalidHandle : reinterpret_cast<intptr_t>(file);
+#else
+        int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+        int fd = ::open(m_path.c_str(), flags, 0644);
+        m_handle = fd < 0 ? InvalidHandle : fd;
+#endif
+
+        uint64_t size = std::filesystem::file_size(m_path, ec);
+        m_fileSize = ec ? 0 : size;
+        return isOpen();
+    }
+
+    void FileSink::closeFile()
+    {
+        if (!isOpen())
+        {
+            return;
+        }
+
+        BufferedSink::flush();
+#ifdef _WIN32
+        CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+#else
+        ::close(static_cast<int>(m_handle));
+#endif
+        m_handle = InvalidHandle;
+    }
+
+    bool FileSink::writeBatch(std::string_view data)
+    {
+        if (!isOpen() || !writeAll(m_handle, data))
+        {
+            return false;
+        }
+        m_fileSize += data.size();
+        return true;
+    }
+
+    RotatingFileSink::RotatingFileSink(std::string path, const RotationOptions &rotation,
+                                       LogLevel threshold, size_t batchBytes)
+        : FileSink(std::move(path), threshold, batchBytes),
+          m_rotation(rotation),
+          m_openedAt(std::chrono::steady_clock::now())
+    {
+    }
+
+    bool RotatingFileSink::writeBatch(std::string_view data)
+    {
+        bool tooLarge = m_fileSize > 0 && m_fileSize + data.size() > m_rotation.maxBytes;
+        bool tooOld = m_rotation.maxAge.count() > 0 &&
+                      std::chrono::steady_clock::now() - m_openedAt >= m_rotation.maxAge;
+        if (tooLarge || tooOld)
+        {
+            rotate();
+        }
+        return FileSink::writeBatch(data);
+    }
+
+    void RotatingFileSink::rotate()
+    {
+        // Called from inside a flush, so close without flushing the batch again
+        if (isOpen())
+        {
+#ifdef _WIN32
+            CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+#else
+            ::close(static_cast<int>(m_handle));
+#endif
+            m_handle = InvalidHandle;
+        }
+
+        std::error_code ec;
+        if (m_rotation.maxFiles == 0)
+        {
+            std::filesystem::remove(m_path, ec);
+        }
+        else
+        {
+            std::filesystem::remove(m_path + "." + std::to_string(m_rotation.maxFiles), ec);
+            for (size_t i = m_rotation.maxFiles - 1; i >= 1; --i)
+            {
+                std::filesystem::rename(m_path + "." + std::to_string(i), m_path + "." + std::to_string(i + 1), ec);
+            }
+            std::filesystem::rename(m_path, m_path + ".1", ec);
+        }
+
+        openFile(true);
+        m_openedAt = std::chrono::steady_clock::now();
+    }
+
+    RingSink::RingSink(size_t capacity, LogLevel threshold)
+        : Sink(threshold), m_lines(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    void RingSink::append(LogLevel, std::string_view line)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // assign() reuses the slot's storage once the ring has wrapped
+        m_lines[m_next].assign(line);
+        if (++m_next == m_lines.size())
+        {
+            m_next = 0;
+            m_wrapped = true;
+        }
+    }
+
+    std::vector<std::string> RingSink::lines() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::string> result;
+        if (m_wrapped)
+        {
+            result.insert(result.end(), m_lines.begin() + m_next, m_lines.end());
+        }
+        result.insert(result.end(), m_lines.begin(), m_lines.begin() + m_next);
+        return result;
+    }
+
+}
@@ -0,0 +1,73 @@
+#include <logging/timestamp_cache.hpp>
+#include <ctime>
+
+namespace core::logging
+{
+
+    namespace
+    {
+        void writeDigits(char *out, int64_t value, int count)
+        {
+            for (int i = count - 1; i >= 0; --i)
+            {
+                out[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+        }
+    }
+
+    TimestampCache::TimestampCache(std::string pattern, SubsecondPrecision precision, char separator)
+        : m_pattern(std::move(pattern)), m_precision(precision), m_separator(separator)
+    {
+    }
+
+    std::string_view TimestampCache::format(std::chrono::system_clock::time_point time)
+    {
+        using namespace std::chrono;
+
+        int64_t micros = duration_cast<microseconds>(time.time_since_epoch()).count();
+        int64_t second = micros / 1'000'000;
+        int64_t fraction = micros % 1'000'000;
+        if (fraction < 0)
+        {
+            fraction += 1'000'000;
+            --second;
+        }
+
+        if (second != m_cachedSecond)
+        {
+            std::time_t timeT = static_cast<std::time_t>(second);
+            std::tm timeInfo;
+#ifdef _WIN32
+            localtime_s(&timeInfo, &timeT);
+#else
+            localtime_r(&timeT, &timeInfo);
+#endif
+            // Leave room for the separator and up to six sub-second digits
+            m_secondsLength = std::strftime(m_buffer, sizeof(m_buffer) - 8, m_pattern.c_str(), &timeInfo);
+            m_cachedSecond = second;
+        }
+
+        size_t length = m_secondsLength;
+        switch (m_precision)
+        {
+        case SubsecondPrecision::Milliseconds:
+            m_buffer[length++] = m_separator;
+            writeDigits(m_buffer + length, fraction / 1000, 3);
+            length += 3;
+            break;
+
+        case SubsecondPrecision::Microseconds:
+            m_buffer[length++] = m_separator;
+            writeDigits(m_buffer + length, fraction, 6);
+            length += 6;
+            break;
+
+        case SubsecondPrecision::None:
+            break;
+        }
+
+        return std::string_view(m_buffer, length);
+    }
+
+}
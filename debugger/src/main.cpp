@@ -1,50 +1,9 @@
 #include <Windows.h>
 #include <logging/logger.hpp>
+#include <logging/sinks.hpp>
 #include <minhook/MinHook.h>
 
-#include <hydra/client.hpp>
-#include <hydra/map.hpp>
-#include <hydra/request.hpp>
-#include <logging/request_logger.hpp>
-
-RequestFileLogger g_file_logger;
-
-typedef void *(*request_response_fn_t)(hydra::Client *client, void *unk, hydra::Request **request_ref);
-PVOID original_request_response_fn = nullptr;
-void *callback_request_response(hydra::Client *client, void *unk, hydra::Request **request_ref)
-{
-    LOG_INFO("Response: 0x{:X}", (uintptr_t)request_ref);
-    hydra::Request *request = *request_ref;
-    if (request_ref && *request_ref)
-    {
-        // Log request information with clean formatting
-        hydra::ValueUtils::log_request_data(*request_ref);
-
-        if (g_file_logger.is_enabled()) {
-            g_file_logger.save_response(client, request);
-        }
-    }
-    else
-    {
-        LOG_INFO("Invalid request reference");
-    }
-
-    printf("\n\n");
-    return ((request_response_fn_t)original_request_response_fn)(client, unk, request_ref);
-}
-
-typedef void *(*make_request_fn_t)(hydra::Client *client, std::string &endpoint, std::string &method, hydra::MapValue *data, void *a5, void *a6, void *a7);
-
-PVOID original_make_request_fn;
-void *callback_make_request(hydra::Client *client, std::string &endpoint, std::string &method, hydra::MapValue *data, void *a5, void *a6, void *callback)
-{
-    LOG_INFO("Making {} request to {}", method, endpoint);
-    hydra::ValueUtils::print_value( data );
-    if (g_file_logger.is_enabled()) {
-        g_file_logger.save_request(client, endpoint, method, data);
-    }
-    return ((make_request_fn_t)original_make_request_fn)(client, endpoint, method, data, a5, a6, callback);
-}
+#include <hooks/callbacks.hpp>
 
 bool setup_hooks()
 {
@@ -88,23 +47,63 @@ DWORD WINAPI MainThread(LPVOID lpParam)
     FILE *f;
     freopen_s(&f, "CONOUT$", "w", stdout);
 
+    /* Full trace on disk; the console only shows warnings and errors */
+    core::logging::RotationOptions rotation;
+    rotation.maxBytes = 64ull * 1024 * 1024;
+    rotation.maxFiles = 5;
+    core::logging::getLogger().clearSinks();
+    core::logging::getLogger().addSink(std::make_shared<core::logging::ConsoleSink>(core::logging::LogLevel::Warning));
+    core::logging::getLogger().addSink(std::make_shared<core::logging::RotatingFileSink>("logs/debugger.log", rotation, core::logging::LogLevel::Trace));
+
+    /* Keep console writes off the game's network thread */
+    core::logging::getLogger().startAsync({ 16384, core::logging::OverflowPolicy::DropOldest });
+
     LOG_INFO("Main thread started");
 
     g_file_logger.enable_logging(true);
     g_file_logger.set_base_directory("request_logs");
+    g_file_logger.set_overhead_monitor(&g_overhead);
+    /* Snapshot on the hook, write files on a background thread */
+    CaptureOptions capture_options;
+    capture_options.payload = CapturePayload::AgBinary;
+    capture_options.compression = core::logging::capture::Compression::Zlib;
+    capture_options.retention_bytes = 4ull * 1024 * 1024 * 1024;
+    capture_options.retention_age = std::chrono::hours(24 * 7);
+    g_file_logger.start(capture_options);
 
     if (!setup_hooks())
     {
         LOG_ERROR("Failed to setup hooks");
+        g_file_logger.stop();
+        core::logging::getLogger().stopAsync();
         FreeLibraryAndExitThread(hDebugModule, 1);
     }
 
-    while (true)
+    /* End unloads the debugger */
+    for (uint32_t tick = 1; !(GetAsyncKeyState(VK_END) & 1); ++tick)
     {
         Sleep(1000);
+        /* Print less while the hooks cost the game too much, more once they don't */
+        g_overhead.evaluate();
+        if (tick % 30 == 0)
+        {
+            g_latency.writeReport("logs/latency.txt");
+            LOG_INFO("{}", g_overhead.report());
+        }
     }
 
     LOG_INFO("Goodbye!");
+    /* No new calls enter the callbacks once the hooks are off. Give a thread
+       that jumped into one just before time to count itself, then wait until
+       every callback, and the game function it chains to, has returned:
+       only then are the trampolines, the logger and this module safe to free */
+    MH_DisableHook(MH_ALL_HOOKS);
+    Sleep(100);
+    while (g_callbacks_in_flight.load(std::memory_order_acquire) != 0)
+        Sleep(10);
+    MH_Uninitialize();
+    g_file_logger.stop();
+    core::logging::getLogger().stopAsync();
     FreeLibraryAndExitThread(hDebugModule, 0);
     return 0;
 }
@@ -112,6 +111,9 @@ DWORD WINAPI MainThread(LPVOID lpParam)
 /* DllMain */
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
 {
+    /* Capture is stopped by MainThread before it unloads us; on
+       DLL_PROCESS_DETACH the loader lock rules out joining the writer
+       or writing files */
     if (ul_reason_for_call != DLL_PROCESS_ATTACH)
         return TRUE;
 
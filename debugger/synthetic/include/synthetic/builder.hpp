@@ -0,0 +1,131 @@
+#pragma once
+// Builds hydra value trees, requests and clients in-process, laid out the way
+// the game lays them out, so the debugger core can be run, measured and
+// checked outside the game.
+//
+//   - Values are the real hydra classes with their own vftables; type()
+//     answers as in the game. Maps are a SyntheticMap whose +0x8 holds the
+//     std::map head node and +0x10 the entry count; lists hold their List
+//     inline at +0x8.
+//   - Map entries form a red-black tree with the MSVC node layout (left,
+//     parent, right, color, is_nil, key, value at 0x0/0x8/0x10/0x18/0x19/
+//     0x20/0x28). The head node is nil, its parent is the root, its left and
+//     right are the smallest and largest entries, and every leaf link points
+//     back to it.
+//   - Request and Client are raw blocks with their fields at the offsets
+//     given in hydra/request.hpp and hydra/client.hpp.
+//
+// Standard-library members (std::string, std::vector) use the host's own
+// layout, which is what the debugger reads them with when built there.
+//
+// Everything is owned by the Builder and freed with it; nodes are never
+// freed individually.
+
+#include <hydra/client.hpp>
+#include <hydra/request.hpp>
+#include <hydra/snapshot.hpp>
+#include <hydra/value.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace synthetic
+{
+    using namespace hydra;
+
+    // The game's map classes are abstract here; this supplies type()
+    class SyntheticMap : public IterableMap
+    {
+    public:
+        void dtor() override {}
+
+        ValueType type() override
+        {
+            return ValueType::Map;
+        }
+    };
+
+    class Builder
+    {
+    public:
+        Builder() = default;
+        ~Builder();
+
+        Builder(const Builder &) = delete;
+        Builder &operator=(const Builder &) = delete;
+
+        Value *integer(int64_t value);
+        Value *number(double value);
+        Value *boolean(bool value);
+        Value *string(std::string_view value);
+        Value *list(std::vector<Value *> items);
+
+        // Entries in any order; for duplicate keys the last one wins.
+        // A nullptr value is kept, as the game does for a null.
+        Value *map(std::vector<std::pair<std::string, Value *>> entries);
+
+        // JSON objects become maps, arrays lists, numbers Integer (or Double
+        // with a fraction, an exponent or outside int64) and null a nullptr
+        // value. Returns nullptr with a description in error if the text does
+        // not parse.
+        Value *from_json(std::string_view json, std::string *error = nullptr);
+
+        // Rebuilds a snapshot (or a decoded capture payload) as a live tree.
+        // Types the builder has no class for (DateTime, Binary, ...) become
+        // nullptr, as does an invalid root.
+        Value *from_snapshot(const SnapshotValue &value);
+
+        // An application/x-ag-binary payload, as stored in captures; nullptr
+        // if it does not decode
+        Value *from_capture(std::string_view payload);
+
+        Request *request(std::string_view endpoint, std::string_view content_type, int32_t response_code, Value *data);
+        Client *client(std::string_view host_address);
+
+        // Values created so far (map keys not included)
+        size_t nodes() const
+        {
+            return m_nodes;
+        }
+
+    private:
+        // Zeroed, 16-byte aligned storage freed with the builder; destroy
+        // (if given) runs first
+        void *allocate(size_t size, void (*destroy)(void *) = nullptr);
+
+        template <typename T>
+        T *create();
+
+        StringValue *key(std::string_view text);
+        MapEntry *link(std::vector<MapEntry *> &entries, size_t low, size_t high, MapEntry *head, MapEntry *parent,
+                       size_t depth, size_t red_depth);
+
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> storage;
+            void (*destroy)(void *);
+            void *object;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_nodes = 0;
+    };
+
+    // Checks a map's tree the way a debugger reading it relies on: head and
+    // sentinel links, parent links, key order and the red-black rules.
+    // Returns false with a description in error.
+    bool verify_map(const MapValue *map, std::string *error = nullptr);
+
+    // An inventory-like response of ~1k nodes, built once per process:
+    // maps of scalars inside a list, as the benchmarks' reference payload
+    struct Tree
+    {
+        Value *root = nullptr;
+        size_t nodes = 0;
+    };
+
+    const Tree &inventory();
+}
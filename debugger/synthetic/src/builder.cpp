@@ -0,0 +1,726 @@
+#include <synthetic/builder.hpp>
+#include <hydra/ag_binary.hpp>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <new>
+
+namespace synthetic
+{
+    namespace
+    {
+        // Field offsets of the game's objects (hydra/request.hpp, hydra/client.hpp)
+        constexpr size_t RequestEndpoint = 0x20;
+        constexpr size_t RequestContentType = 0x68;
+        constexpr size_t RequestResponseCode = 0xFC;
+        constexpr size_t RequestData = 0x120;
+        constexpr size_t RequestSize = RequestData + sizeof(Value *);
+        constexpr size_t ClientHostAddress = 0x30;
+
+        static_assert(RequestEndpoint + sizeof(std::string) <= RequestContentType);
+        static_assert(RequestContentType + sizeof(std::string) <= RequestResponseCode);
+
+        // Map object: std::map head node, then its size
+        constexpr size_t MapHead = 0x8;
+        constexpr size_t MapSize = 0x10;
+        constexpr size_t ListOffset = 0x8;
+
+        // MSVC _Tree_node colors
+        constexpr bool Red = false;
+        constexpr bool Black = true;
+
+        template <typename T>
+        T &field(void *object, size_t offset)
+        {
+            return *reinterpret_cast<T *>(static_cast<std::byte *>(object) + offset);
+        }
+
+        template <typename T>
+        void destroy_at_offset(void *object, size_t offset)
+        {
+            std::destroy_at(&field<T>(object, offset));
+        }
+
+        class JsonParser
+        {
+        public:
+            static constexpr size_t MaxDepth = 512;
+
+            JsonParser(Builder &builder, std::string_view text) : m_builder(builder), m_text(text) {}
+
+            bool parse(Value *&out)
+            {
+                if (!value(out, 0))
+                {
+                    return false;
+                }
+                skip_spaces();
+                return m_pos == m_text.size() || fail("trailing characters");
+            }
+
+            const std::string &error() const
+            {
+                return m_error;
+            }
+
+        private:
+            bool fail(std::string_view message)
+            {
+                m_error = std::format("{} at offset {}", message, m_pos);
+                return false;
+            }
+
+            void skip_spaces()
+            {
+                while (m_pos < m_text.size() && std::string_view(" \t\r\n").find(m_text[m_pos]) != std::string_view::npos)
+                {
+                    ++m_pos;
+                }
+            }
+
+            bool consume(char c)
+            {
+                skip_spaces();
+                if (m_pos < m_text.size() && m_text[m_pos] == c)
+                {
+                    ++m_pos;
+                    return true;
+                }
+                return false;
+            }
+
+            bool literal(std::string_view word)
+            {
+                if (m_text.substr(m_pos).starts_with(word))
+                {
+                    m_pos += word.size();
+                    return true;
+                }
+                return false;
+            }
+
+            bool value(Value *&out, size_t depth)
+            {
+                if (depth > MaxDepth)
+                {
+                    return fail("nested too deeply");
+                }
+
+                skip_spaces();
+                if (m_pos >= m_text.size())
+                {
+                    return fail("unexpected end");
+                }
+
+                char c = m_text[m_pos];
+                if (c == '{')
+                {
+                    return object(out, depth);
+                }
+                if (c == '[')
+                {
+                    return array(out, depth);
+                }
+                if (c == '"')
+                {
+                    std::string text;
+                    if (!string(text))
+                    {
+                        return false;
+                    }
+                    out = m_builder.string(text);
+                    return true;
+                }
+                if (literal("true") || literal("false"))
+                {
+                    out = m_builder.boolean(c == 't');
+                    return true;
+                }
+                if (literal("null"))
+                {
+                    out = nullptr;
+                    return true;
+                }
+                return number(out);
+            }
+
+            bool object(Value *&out, size_t depth)
+            {
+                ++m_pos;
+                std::vector<std::pair<std::string, Value *>> entries;
+                if (!consume('}'))
+                {
+                    do
+                    {
+                        skip_spaces();
+                        std::string key;
+                        if (m_pos >= m_text.size() || m_text[m_pos] != '"')
+                        {
+                            return fail("expected a key");
+                        }
+                        if (!string(key))
+                        {
+                            return false;
+                        }
+                        if (!consume(':'))
+                        {
+                            return fail("expected ':'");
+                        }
+                        Value *child;
+                        if (!value(child, depth + 1))
+                        {
+                            return false;
+                        }
+                        entries.emplace_back(std::move(key), child);
+                    } while (consume(','));
+
+                    if (!consume('}'))
+                    {
+                        return fail("expected ',' or '}'");
+                    }
+                }
+                out = m_builder.map(std::move(entries));
+                return true;
+            }
+
+            bool array(Value *&out, size_t depth)
+            {
+                ++m_pos;
+                std::vector<Value *> items;
+                if (!consume(']'))
+                {
+                    do
+                    {
+                        if (!value(items.emplace_back(), depth + 1))
+                        {
+                            return false;
+                        }
+                    } while (consume(','));
+
+                    if (!consume(']'))
+                    {
+                        return fail("expected ',' or ']'");
+                    }
+                }
+                out = m_builder.list(std::move(items));
+                return true;
+            }
+
+            bool hex4(uint32_t &out)
+            {
+                if (m_pos + 4 > m_text.size())
+                {
+                    return fail("truncated \\u escape");
+                }
+                auto [end, ec] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_pos + 4, out, 16);
+                if (ec != std::errc() || end != m_text.data() + m_pos + 4)
+                {
+                    return fail("invalid \\u escape");
+                }
+                m_pos += 4;
+                return true;
+            }
+
+            static void append_utf8(std::string &out, uint32_t code)
+            {
+                if (code < 0x80)
+                {
+                    out.push_back(static_cast<char>(code));
+                }
+                else if (code < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if (code < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+            }
+
+            bool string(std::string &out)
+            {
+                ++m_pos;
+                while (m_pos < m_text.size())
+                {
+                    char c = m_text[m_pos++];
+                    if (c == '"')
+                    {
+                        return true;
+                    }
+                    if (c != '\\')
+                    {
+                        out.push_back(c);
+                        continue;
+                    }
+                    if (m_pos >= m_text.size())
+                    {
+                        break;
+                    }
+
+                    char escape = m_text[m_pos++];
+                    switch (escape)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        out.push_back(escape);
+                        break;
+                    case 'b':
+                        out.push_back('\b');
+                        break;
+                    case 'f':
+                        out.push_back('\f');
+                        break;
+                    case 'n':
+                        out.push_back('\n');
+                        break;
+                    case 'r':
+                        out.push_back('\r');
+                        break;
+                    case 't':
+                        out.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        uint32_t code = 0;
+                        if (!hex4(code))
+                        {
+                            return false;
+                        }
+                        // Surrogate pair: a high half must be followed by a low one
+                        if (code >= 0xDC00 && code < 0xE000)
+                        {
+                            return fail("unpaired low surrogate");
+                        }
+                        if (code >= 0xD800 && code < 0xDC00)
+                        {
+                            if (!m_text.substr(m_pos).starts_with("\\u"))
+                            {
+                                return fail("unpaired high surrogate");
+                            }
+                            m_pos += 2;
+                            uint32_t low = 0;
+                            if (!hex4(low))
+                            {
+                                return false;
+                            }
+                            if (low < 0xDC00 || low >= 0xE000)
+                            {
+                                return fail("invalid low surrogate");
+                            }
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        append_utf8(out, code);
+                        break;
+                    }
+                    default:
+                        return fail("invalid escape");
+                    }
+                }
+                return fail("unterminated string");
+            }
+
+            bool number(Value *&out)
+            {
+                const char *begin = m_text.data() + m_pos;
+                const char *end = m_text.data() + m_text.size();
+
+                int64_t integer;
+                double number;
+                auto integer_result = std::from_chars(begin, end, integer);
+                auto double_result = std::from_chars(begin, end, number);
+                if (double_result.ec != std::errc())
+                {
+                    return fail("unexpected character");
+                }
+
+                if (integer_result.ec == std::errc() && integer_result.ptr == double_result.ptr)
+                {
+                    out = m_builder.integer(integer);
+                }
+                else
+                {
+                    out = m_builder.number(number);
+                }
+                m_pos += double_result.ptr - begin;
+                return true;
+            }
+
+            Builder &m_builder;
+            std::string_view m_text;
+            size_t m_pos = 0;
+            std::string m_error;
+        };
+
+        // Black height of node's subtree, or -1 with error set
+        int check_subtree(const MapEntry *node, const MapEntry *parent, const MapEntry *head, const std::string *low,
+                          const std::string *high, size_t depth, std::string &error)
+        {
+            if (node == head)
+            {
+                return 1;
+            }
+            if (!node || node->is_last)
+            {
+                error = "leaf link does not point to the head node";
+                return -1;
+            }
+            if (depth >= MapValue::MaxTreeDepth)
+            {
+                error = "tree deeper than MapValue::MaxTreeDepth";
+                return -1;
+            }
+            if (node->padding01 != parent)
+            {
+                error = "parent link mismatch";
+                return -1;
+            }
+            if (!node->key)
+            {
+                error = "entry without a key";
+                return -1;
+            }
+
+            const std::string &key = node->key->value;
+            if ((low && !(*low < key)) || (high && !(key < *high)))
+            {
+                error = std::format("key '{}' out of order", key);
+                return -1;
+            }
+            if (node->padding02 == Red && ((node->left_child != head && node->left_child->padding02 == Red) ||
+                                           (node->right_child != head && node->right_child->padding02 == Red)))
+            {
+                error = std::format("red entry '{}' has a red child", key);
+                return -1;
+            }
+
+            int left = check_subtree(node->left_child, node, head, low, &key, depth + 1, error);
+            if (left < 0)
+            {
+                return -1;
+            }
+            int right = check_subtree(node->right_child, node, head, &key, high, depth + 1, error);
+            if (right < 0)
+            {
+                return -1;
+            }
+            if (left != right)
+            {
+                error = std::format("black heights differ under '{}'", key);
+                return -1;
+            }
+            return left + (node->padding02 == Black ? 1 : 0);
+        }
+    }
+
+    Builder::~Builder()
+    {
+        for (auto it = m_blocks.rbegin(); it != m_blocks.rend(); ++it)
+        {
+            if (it->destroy)
+            {
+                it->destroy(it->object);
+            }
+        }
+    }
+
+    void *Builder::allocate(size_t size, void (*destroy)(void *))
+    {
+        // operator new[] storage is aligned for any fundamental type
+        std::unique_ptr<std::byte[]> storage(new std::byte[size]());
+        void *object = storage.get();
+        m_blocks.push_back(Block{std::move(storage), destroy, object});
+        return object;
+    }
+
+    template <typename T>
+    T *Builder::create()
+    {
+        void *storage = allocate(sizeof(T), [](void *object) { std::destroy_at(static_cast<T *>(object)); });
+        return new (storage) T();
+    }
+
+    Value *Builder::integer(int64_t value)
+    {
+        IntegerValue *result = create<IntegerValue>();
+        result->value() = value;
+        ++m_nodes;
+        return result;
+    }
+
+    Value *Builder::number(double value)
+    {
+        DoubleValue *result = create<DoubleValue>();
+        result->value = value;
+        ++m_nodes;
+        return result;
+    }
+
+    Value *Builder::boolean(bool value)
+    {
+        BooleanValue *result = create<BooleanValue>();
+        result->value = value;
+        ++m_nodes;
+        return result;
+    }
+
+    Value *Builder::string(std::string_view value)
+    {
+        StringValue *result = create<StringValue>();
+        result->value.assign(value);
+        ++m_nodes;
+        return result;
+    }
+
+    StringValue *Builder::key(std::string_view text)
+    {
+        StringValue *result = create<StringValue>();
+        result->value.assign(text);
+        return result;
+    }
+
+    Value *Builder::list(std::vector<Value *> items)
+    {
+        // ListValue holds its List inline at +0x8
+        void *storage = allocate(ListOffset + sizeof(List), [](void *object) { destroy_at_offset<List>(object, ListOffset); });
+        ListValue *result = new (storage) ListValue();
+        new (&field<List>(storage, ListOffset)) List{std::move(items)};
+        ++m_nodes;
+        return result;
+    }
+
+    MapEntry *Builder::link(std::vector<MapEntry *> &entries, size_t low, size_t high, MapEntry *head, MapEntry *parent,
+                            size_t depth, size_t red_depth)
+    {
+        if (low >= high)
+        {
+            return head;
+        }
+
+        size_t middle = low + (high - low) / 2;
+        MapEntry *entry = entries[middle];
+        entry->padding01 = parent;
+        entry->padding02 = depth == red_depth ? Red : Black;
+        entry->left_child = link(entries, low, middle, head, entry, depth + 1, red_depth);
+        entry->right_child = link(entries, middle + 1, high, head, entry, depth + 1, red_depth);
+        return entry;
+    }
+
+    Value *Builder::map(std::vector<std::pair<std::string, Value *>> entries)
+    {
+        // Sorted, keeping the last of any duplicate keys
+        std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        std::vector<MapEntry *> nodes;
+        nodes.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first)
+            {
+                continue;
+            }
+            MapEntry *entry = static_cast<MapEntry *>(allocate(sizeof(MapEntry)));
+            entry->key = key(entries[i].first);
+            entry->value = entries[i].second;
+            nodes.push_back(entry);
+        }
+
+        MapEntry *head = static_cast<MapEntry *>(allocate(sizeof(MapEntry)));
+        head->is_last = true;
+        head->padding02 = Black;
+
+        // Halving the sorted entries fills every level but the last; making
+        // that level red (unless it is full) gives every path the same
+        // number of black entries
+        size_t count = nodes.size();
+        size_t red_depth = std::has_single_bit(count + 1) ? SIZE_MAX : std::bit_width(count) - 1;
+        MapEntry *root = link(nodes, 0, count, head, head, 0, red_depth);
+
+        head->padding01 = root;
+        head->left_child = count ? nodes.front() : head;
+        head->right_child = count ? nodes.back() : head;
+
+        SyntheticMap *result = create<SyntheticMap>();
+        field<MapEntry *>(result, MapHead) = head;
+        field<size_t>(result, MapSize) = count;
+        ++m_nodes;
+        return result;
+    }
+
+    Value *Builder::from_json(std::string_view json, std::string *error)
+    {
+        JsonParser parser(*this, json);
+        Value *result = nullptr;
+        if (!parser.parse(result))
+        {
+            if (error)
+            {
+                *error = parser.error();
+            }
+            return nullptr;
+        }
+        return result;
+    }
+
+    Value *Builder::from_snapshot(const SnapshotValue &value)
+    {
+        if (!value.valid())
+        {
+            return nullptr;
+        }
+
+        switch (value.type())
+        {
+        case ValueType::Integer:
+            return integer(value.as<int64_t>());
+        case ValueType::Double:
+            return number(value.as<double>());
+        case ValueType::Boolean:
+            return boolean(value.as<bool>());
+        case ValueType::String:
+            return string(value.as<std::string_view>());
+        case ValueType::Map:
+        {
+            std::vector<std::pair<std::string, Value *>> entries;
+            entries.reserve(value.size());
+            for (auto it = value.begin(); it != value.end(); ++it)
+            {
+                entries.emplace_back(std::string(it.key()), from_snapshot(*it));
+            }
+            return map(std::move(entries));
+        }
+        case ValueType::List:
+        {
+            std::vector<Value *> items;
+            items.reserve(value.size());
+            for (auto it = value.begin(); it != value.end(); ++it)
+            {
+                items.push_back(from_snapshot(*it));
+            }
+            return list(std::move(items));
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    Value *Builder::from_capture(std::string_view payload)
+    {
+        ValueSnapshot snapshot;
+        if (!ag_binary::decode(payload, snapshot))
+        {
+            return nullptr;
+        }
+        return from_snapshot(snapshot.root());
+    }
+
+    Request *Builder::request(std::string_view endpoint, std::string_view content_type, int32_t response_code, Value *data)
+    {
+        void *storage = allocate(RequestSize, [](void *object) {
+            destroy_at_offset<std::string>(object, RequestEndpoint);
+            destroy_at_offset<std::string>(object, RequestContentType);
+        });
+        new (&field<std::string>(storage, RequestEndpoint)) std::string(endpoint);
+        new (&field<std::string>(storage, RequestContentType)) std::string(content_type);
+        field<int32_t>(storage, RequestResponseCode) = response_code;
+        field<Value *>(storage, RequestData) = data;
+        return static_cast<Request *>(storage);
+    }
+
+    Client *Builder::client(std::string_view host_address)
+    {
+        void *storage = allocate(ClientHostAddress + sizeof(std::string), [](void *object) {
+            destroy_at_offset<std::string>(object, ClientHostAddress);
+        });
+        new (&field<std::string>(storage, ClientHostAddress)) std::string(host_address);
+        return static_cast<Client *>(storage);
+    }
+
+    bool verify_map(const MapValue *map, std::string *error)
+    {
+        std::string message;
+        auto fail = [&](std::string text) {
+            if (error)
+            {
+                *error = std::move(text);
+            }
+            return false;
+        };
+
+        const MapEntry *head = map ? map->head() : nullptr;
+        if (!head)
+        {
+            return fail("no head node");
+        }
+        if (!head->is_last || head->padding02 != Black)
+        {
+            return fail("head node is not a black nil node");
+        }
+
+        const MapEntry *root = static_cast<const MapEntry *>(head->padding01);
+        if (root == head)
+        {
+            return head->left_child == head && head->right_child == head ? true : fail("empty map's head links are not to itself");
+        }
+        if (!root || root->padding02 != Black)
+        {
+            return fail("root is missing or red");
+        }
+        if (check_subtree(root, head, head, nullptr, nullptr, 0, message) < 0)
+        {
+            return fail(message);
+        }
+
+        const MapEntry *leftmost = root;
+        while (leftmost->left_child != head)
+        {
+            leftmost = leftmost->left_child;
+        }
+        const MapEntry *rightmost = root;
+        while (rightmost->right_child != head)
+        {
+            rightmost = rightmost->right_child;
+        }
+        if (head->left_child != leftmost || head->right_child != rightmost)
+        {
+            return fail("head's left/right are not the smallest/largest entries");
+        }
+        return true;
+    }
+
+    const Tree &inventory()
+    {
+        static const Tree tree = [] {
+            // Lives as long as the process, like the tree it returns
+            Builder *builder = new Builder();
+            std::vector<Value *> items;
+            for (int i = 0; i < 120; ++i)
+            {
+                items.push_back(builder->map({
+                    {"id", builder->string(std::format("item_{:05}", i))},
+                    {"count", builder->integer(i % 7)},
+                    {"level", builder->integer(100000 + i)},
+                    {"tags", builder->list({builder->string("gear"), builder->string("epic")})},
+                }));
+            }
+            Value *root = builder->map({
+                {"items", builder->list(std::move(items))},
+                {"owner", builder->string("player_0001")},
+                {"revision", builder->integer(42)},
+            });
+            return Tree{root, builder->nodes()};
+        }();
+        return tree;
+    }
+}
@@ -0,0 +1,227 @@
+// Checks the map walks and the capture round trip against brute force, over
+// random trees from synthetic::Builder:
+//
+//   - every map built passes synthetic::verify_map;
+//   - MapIterator visits the keys in std::set order;
+//   - find_entry, contains and get_many agree with a linear search;
+//   - lower_bound, upper_bound and prefix_scan match std::set;
+//   - ag_binary::encode, decode and hydra::diff find no difference, and
+//     encoding the decoded tree gives the same bytes.
+//
+// Usage:
+//
+//   map-tree-test [--seed N] [--rounds N]
+//
+// Prints each failed check and exits 1 if there was one.
+
+#include <hydra/ag_binary.hpp>
+#include <hydra/snapshot.hpp>
+#include <hydra/value_diff.hpp>
+#include <synthetic/builder.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace hydra;
+
+namespace
+{
+    size_t s_failures = 0;
+
+    void check(bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            std::cerr << "FAILED: " << what << "\n";
+            ++s_failures;
+        }
+    }
+
+    // Keys over a small alphabet, so that many share a prefix
+    std::string randomKey(std::mt19937_64 &random)
+    {
+        static constexpr std::string_view Alphabet = "abc_";
+        std::string key(1 + random() % 6, ' ');
+        for (char &c : key)
+        {
+            c = Alphabet[random() % Alphabet.size()];
+        }
+        return key;
+    }
+
+    Value *randomValue(synthetic::Builder &builder, std::mt19937_64 &random, size_t depth);
+
+    // Adds the keys it used to keys when given
+    Value *randomMap(synthetic::Builder &builder, std::mt19937_64 &random, size_t entries, size_t depth,
+                     std::set<std::string> *keys = nullptr)
+    {
+        std::vector<std::pair<std::string, Value *>> items;
+        for (size_t i = 0; i < entries; ++i)
+        {
+            items.emplace_back(randomKey(random), randomValue(builder, random, depth + 1));
+            if (keys)
+            {
+                keys->insert(items.back().first);
+            }
+        }
+        return builder.map(std::move(items));
+    }
+
+    Value *randomValue(synthetic::Builder &builder, std::mt19937_64 &random, size_t depth)
+    {
+        switch (random() % (depth < 3 ? 7 : 5))
+        {
+        case 0:
+            return builder.integer(static_cast<int64_t>(random()));
+        case 1:
+            return builder.number(static_cast<double>(random() % 100000) / 7);
+        case 2:
+            return builder.boolean(random() % 2);
+        case 3:
+            return builder.string(randomKey(random));
+        case 4:
+            return nullptr;
+        case 5:
+        {
+            std::vector<Value *> items;
+            for (size_t i = random() % 5; i > 0; --i)
+            {
+                items.push_back(randomValue(builder, random, depth + 1));
+            }
+            return builder.list(std::move(items));
+        }
+        default:
+            return randomMap(builder, random, random() % 8, depth);
+        }
+    }
+
+    std::vector<std::string> keysOf(const MapRange &range)
+    {
+        std::vector<std::string> keys;
+        for (MapIterator it = range.begin(); it != range.end(); ++it)
+        {
+            keys.emplace_back(it.key());
+        }
+        return keys;
+    }
+
+    std::vector<std::string> keysOf(std::set<std::string>::const_iterator first, std::set<std::string>::const_iterator last)
+    {
+        return std::vector<std::string>(first, last);
+    }
+
+    void checkMap(std::mt19937_64 &random, size_t round)
+    {
+        synthetic::Builder builder;
+        size_t size = random() % 200;
+        std::set<std::string> keys;
+        auto *map = static_cast<IterableMap *>(randomMap(builder, random, size, 0, &keys));
+        std::string where = std::format("round {} ({} entries)", round, size);
+
+        std::string error;
+        check(synthetic::verify_map(map, &error), std::format("{}: verify_map: {}", where, error));
+
+        std::vector<std::string> walked = keysOf(MapRange{map->begin(), map->end()});
+        check(walked == keysOf(keys.begin(), keys.end()), std::format("{}: MapIterator order", where));
+
+        // Every key of the map, plus misses and prefixes of them
+        std::vector<std::string> probes(keys.begin(), keys.end());
+        for (size_t i = 0; i < 50; ++i)
+        {
+            probes.push_back(randomKey(random));
+        }
+        probes.push_back("");
+
+        std::vector<std::string_view> batch;
+        for (const std::string &probe : probes)
+        {
+            MapEntry *entry = map->find_entry(probe);
+            bool present = keys.contains(probe);
+            check(present == (entry != nullptr) && (!entry || entry->key->value == probe),
+                  std::format("{}: find_entry(\"{}\")", where, probe));
+            check(map->contains(probe) == present, std::format("{}: contains(\"{}\")", where, probe));
+
+            check(keysOf(MapRange{map->lower_bound(probe), map->end()}) == keysOf(keys.lower_bound(probe), keys.end()),
+                  std::format("{}: lower_bound(\"{}\")", where, probe));
+            check(keysOf(MapRange{map->upper_bound(probe), map->end()}) == keysOf(keys.upper_bound(probe), keys.end()),
+                  std::format("{}: upper_bound(\"{}\")", where, probe));
+
+            std::vector<std::string> prefixed;
+            std::copy_if(keys.begin(), keys.end(), std::back_inserter(prefixed),
+                         [&](const std::string &key) { return key.starts_with(probe); });
+            check(keysOf(map->prefix_scan(probe)) == prefixed, std::format("{}: prefix_scan(\"{}\")", where, probe));
+
+            if (random() % 3 == 0)
+            {
+                batch.push_back(probe);
+            }
+        }
+
+        // get_many against one linear search per key
+        std::vector<Value *> values(batch.size());
+        size_t found = map->get_many(batch, values);
+        size_t present = 0;
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            Value *expected = nullptr;
+            for (MapIterator it = map->begin(); it != map->end(); ++it)
+            {
+                if (it.key() == batch[i])
+                {
+                    expected = map->find_entry(batch[i])->value;
+                    ++present;
+                }
+            }
+            check(values[i] == expected, std::format("{}: get_many key \"{}\"", where, batch[i]));
+        }
+        check(found == present, std::format("{}: get_many found {} of {}", where, found, present));
+
+        // Capture round trip
+        ValueSnapshot snapshot = ValueSnapshot::capture(ValueVariant(map));
+        std::string encoded;
+        ag_binary::encode(snapshot, encoded);
+        ValueSnapshot decoded;
+        check(ag_binary::decode(encoded, decoded), std::format("{}: ag_binary::decode", where));
+        check(diff(snapshot, decoded).empty(), std::format("{}: diff after round trip", where));
+        std::string reencoded;
+        ag_binary::encode(decoded, reencoded);
+        check(reencoded == encoded, std::format("{}: re-encoded bytes", where));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 1;
+    size_t rounds = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--rounds" && i + 1 < argc)
+        {
+            rounds = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::cerr << "Usage: map-tree-test [--seed N] [--rounds N]\n";
+            return 2;
+        }
+    }
+
+    std::mt19937_64 random(seed);
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        checkMap(random, round);
+    }
+
+    std::cerr << std::format("{} rounds, {} failed checks\n", rounds, s_failures);
+    return s_failures == 0 ? 0 : 1;
+}
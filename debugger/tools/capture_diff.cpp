@@ -0,0 +1,403 @@
+// Compares two capture stores endpoint by endpoint, e.g. one recorded against
+// the official server and one against nemesis.
+//
+// Usage:
+//   capture-diff <old_store> <new_store> [--threads N] [--endpoint SUBSTRING] [--requests]
+//
+// Captures are grouped by endpoint path (scheme, host and query dropped) and
+// the i-th response of an endpoint in one store is diffed against the i-th in
+// the other; --requests compares request bodies instead. Only ag-binary
+// payloads are compared; text captures cannot be parsed back. Differences
+// are reported by endpoint in sorted order.
+//
+// Both stores are streamed in one pass. A capture is held only until the
+// other store reaches it, so memory follows how far the stores drift apart,
+// not their size; matched pairs are decoded and diffed by N worker threads
+// (default one per core).
+//
+// Exits with 0 if the stores match, 1 if anything differs and 2 on bad usage.
+
+#include <hydra/ag_binary.hpp>
+#include <hydra/value_diff.hpp>
+#include <hydra/value_visitor.hpp>
+#include <logging/capture_store.hpp>
+#include <logging/latency_tracker.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace core::logging;
+
+namespace
+{
+    constexpr size_t MaxValueLength = 96;
+
+    struct Options
+    {
+        std::string oldStore;
+        std::string newStore;
+        unsigned threads = 0; // 0: one per core
+        std::string endpointFilter;
+        capture::Direction direction = capture::Direction::Response;
+    };
+
+    // One endpoint's captures as the stores are read, and what diffing them found
+    struct EndpointState
+    {
+        // Read by the reading thread only
+        size_t oldCount = 0;
+        size_t newCount = 0;
+        std::deque<std::string> oldPending; // Read from one store, not yet matched in the other
+        std::deque<std::string> newPending;
+
+        // Written by the workers under the results mutex
+        std::map<size_t, std::string> lines; // Report lines per capture index
+        size_t differences = 0;
+    };
+
+    // The i-th capture of an endpoint in both stores
+    struct Pair
+    {
+        EndpointState *endpoint;
+        size_t index;
+        std::string oldPayload;
+        std::string newPayload;
+    };
+
+    // Hands pairs from the reading thread to the workers. Bounded, so reading
+    // waits for the workers rather than decoding ahead into memory.
+    class PairQueue
+    {
+    public:
+        explicit PairQueue(size_t capacity) : m_capacity(capacity) {}
+
+        void push(Pair &&pair)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notFull.wait(lock, [&] { return m_pairs.size() < m_capacity; });
+            m_pairs.push_back(std::move(pair));
+            m_notEmpty.notify_one();
+        }
+
+        // False once closed and drained
+        bool pop(Pair &pair)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [&] { return !m_pairs.empty() || m_closed; });
+            if (m_pairs.empty())
+            {
+                return false;
+            }
+            pair = std::move(m_pairs.front());
+            m_pairs.pop_front();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_notEmpty.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::deque<Pair> m_pairs;
+        size_t m_capacity;
+        bool m_closed = false;
+    };
+
+    // The captures of one store that pass the filters, segment by segment
+    class StoreStream
+    {
+    public:
+        StoreStream(const std::string &directory, const Options &options)
+            : m_segments(listCaptureSegments(directory)), m_options(options)
+        {
+        }
+
+        // False at the end of the store
+        bool next(CaptureEntry &entry)
+        {
+            for (;;)
+            {
+                if (!m_reader || !m_reader->next(entry))
+                {
+                    if (!openNext())
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                if (entry.direction != m_options.direction)
+                {
+                    continue;
+                }
+
+                std::string_view path = LatencyTracker::endpointPath(entry.endpoint);
+                if (!m_options.endpointFilter.empty() && path.find(m_options.endpointFilter) == std::string_view::npos)
+                {
+                    continue;
+                }
+
+                if (entry.payloadFormat != capture::PayloadFormat::AgBinary)
+                {
+                    ++m_skipped;
+                    continue;
+                }
+                return true;
+            }
+        }
+
+        // Captures without an ag-binary payload
+        size_t skipped() const
+        {
+            return m_skipped;
+        }
+
+    private:
+        bool openNext()
+        {
+            m_reader.reset();
+            while (m_segment < m_segments.size())
+            {
+                const std::string &segment = m_segments[m_segment++];
+                auto reader = std::make_unique<CaptureSegmentReader>(segment);
+                if (reader->isValid())
+                {
+                    m_reader = std::move(reader);
+                    return true;
+                }
+                std::cerr << "Skipping " << segment << ": not a capture segment\n";
+            }
+            return false;
+        }
+
+        std::vector<std::string> m_segments;
+        size_t m_segment = 0;
+        std::unique_ptr<CaptureSegmentReader> m_reader;
+        const Options &m_options;
+        size_t m_skipped = 0;
+    };
+
+    // Compact JSON, cut short for one-line output
+    std::string describe(const hydra::SnapshotValue &value)
+    {
+        if (!value.valid())
+        {
+            return "(none)";
+        }
+
+        std::string text;
+        hydra::JsonEmitter emitter(text);
+        hydra::visit(value, emitter);
+        if (text.size() > MaxValueLength)
+        {
+            text.resize(MaxValueLength);
+            text += "...";
+        }
+        return text;
+    }
+
+    // Report lines for one pair, and how many differences they hold
+    size_t diffPair(const Pair &pair, std::string &out)
+    {
+        size_t i = pair.index;
+        hydra::ValueSnapshot oldTree;
+        hydra::ValueSnapshot newTree;
+        if (!hydra::ag_binary::decode(pair.oldPayload, oldTree) || !hydra::ag_binary::decode(pair.newPayload, newTree))
+        {
+            out += std::format("  #{}: malformed payload\n", i);
+            return 1;
+        }
+
+        size_t differences = 0;
+        for (const hydra::ValueDifference &difference : hydra::diff(oldTree, newTree))
+        {
+            std::string_view path = difference.path.empty() ? std::string_view("(root)") : std::string_view(difference.path);
+            switch (difference.kind)
+            {
+            case hydra::ValueDifference::Kind::Added:
+                out += std::format("  #{} + {}: {}\n", i, path, describe(difference.new_value));
+                break;
+            case hydra::ValueDifference::Kind::Removed:
+                out += std::format("  #{} - {}: {}\n", i, path, describe(difference.old_value));
+                break;
+            case hydra::ValueDifference::Kind::Changed:
+                out += std::format("  #{} ~ {}: {} -> {}\n", i, path, describe(difference.old_value),
+                                   describe(difference.new_value));
+                break;
+            }
+            ++differences;
+        }
+        return differences;
+    }
+
+    int run(const Options &options)
+    {
+        using Endpoints = std::map<std::string, EndpointState, std::less<>>;
+        Endpoints endpoints;
+        std::mutex resultsMutex;
+
+        unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        PairQueue queue(threads * 4);
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            pool.emplace_back([&] {
+                Pair pair;
+                std::string lines;
+                while (queue.pop(pair))
+                {
+                    lines.clear();
+                    size_t differences = diffPair(pair, lines);
+                    if (differences > 0)
+                    {
+                        std::lock_guard<std::mutex> lock(resultsMutex);
+                        pair.endpoint->lines[pair.index] = lines;
+                        pair.endpoint->differences += differences;
+                    }
+                }
+            });
+        }
+
+        // Both stores are read once, side by side, always from the one with
+        // fewer unmatched captures. A capture waits in memory only until the
+        // other store reaches the same index of its endpoint; then the pair
+        // goes to the workers.
+        StoreStream streams[2] = {StoreStream(options.oldStore, options), StoreStream(options.newStore, options)};
+        bool open[2] = {true, true};
+        size_t pending[2] = {0, 0};
+        CaptureEntry entry;
+        while (open[0] || open[1])
+        {
+            int side = !open[0] ? 1 : !open[1] ? 0 : pending[0] <= pending[1] ? 0 : 1;
+            if (!streams[side].next(entry))
+            {
+                open[side] = false;
+                continue;
+            }
+
+            std::string_view path = LatencyTracker::endpointPath(entry.endpoint);
+            auto it = endpoints.find(path);
+            if (it == endpoints.end())
+            {
+                it = endpoints.emplace(std::string(path), EndpointState()).first;
+            }
+            EndpointState &state = it->second;
+
+            size_t &count = side == 0 ? state.oldCount : state.newCount;
+            std::deque<std::string> &mine = side == 0 ? state.oldPending : state.newPending;
+            std::deque<std::string> &theirs = side == 0 ? state.newPending : state.oldPending;
+            if (theirs.empty())
+            {
+                mine.push_back(std::move(entry.payload));
+                ++pending[side];
+            }
+            else
+            {
+                std::string other = std::move(theirs.front());
+                theirs.pop_front();
+                --pending[1 - side];
+                Pair pair{&state, count, {}, {}};
+                pair.oldPayload = side == 0 ? std::move(entry.payload) : std::move(other);
+                pair.newPayload = side == 0 ? std::move(other) : std::move(entry.payload);
+                queue.push(std::move(pair));
+            }
+            ++count;
+        }
+
+        queue.close();
+        for (std::thread &thread : pool)
+        {
+            thread.join();
+        }
+
+        if (streams[0].skipped() + streams[1].skipped() > 0)
+        {
+            std::cerr << "Skipped " << streams[0].skipped() + streams[1].skipped()
+                      << " captures without an ag-binary payload\n";
+        }
+
+        size_t differing = 0;
+        for (auto &[endpoint, state] : endpoints)
+        {
+            std::string report;
+            if (state.oldCount != state.newCount)
+            {
+                report += std::format("  capture count: {} -> {}\n", state.oldCount, state.newCount);
+                ++state.differences;
+            }
+            if (state.differences == 0)
+            {
+                continue;
+            }
+
+            for (const auto &[index, lines] : state.lines)
+            {
+                report += lines;
+            }
+            std::cout << std::format("{} ({} difference{})\n", endpoint, state.differences,
+                                     state.differences == 1 ? "" : "s")
+                      << report;
+            ++differing;
+        }
+        std::cerr << "Compared " << endpoints.size() << " endpoints, " << differing << " differ\n";
+        return differing == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    std::vector<std::string> positional;
+    bool valid = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--endpoint" && i + 1 < argc)
+        {
+            options.endpointFilter = argv[++i];
+        }
+        else if (arg == "--requests")
+        {
+            options.direction = capture::Direction::Request;
+        }
+        else if (arg.starts_with("--"))
+        {
+            valid = false;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+
+    if (!valid || positional.size() != 2)
+    {
+        std::cerr << "Usage:\n"
+                  << "  " << argv[0] << " <old_store> <new_store> [--threads N] [--endpoint SUBSTRING] [--requests]\n";
+        return 2;
+    }
+
+    options.oldStore = positional[0];
+    options.newStore = positional[1];
+    return run(options);
+}
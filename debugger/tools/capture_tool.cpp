@@ -0,0 +1,300 @@
+// Reads a segmented capture store written by RequestFileLogger.
+//
+// Usage:
+//   capture-tool list <store_dir>                      one line per segment
+//   capture-tool dump <store_dir>                      one line per record
+//   capture-tool materialize <store_dir> <output_dir>  rebuild the per-file directory layout
+//   capture-tool convert <store_dir> text|json         every record with its payload decoded;
+//                                                      json writes one object per line
+//   capture-tool query <store_dir> <path>              values selected by a path expression
+//                                                      (see hydra/path_query.hpp), one per line
+
+#include <hydra/ag_binary.hpp>
+#include <hydra/path_query.hpp>
+#include <hydra/value_visitor.hpp>
+#include <logging/capture_layout.hpp>
+#include <logging/capture_store.hpp>
+#include <logging/timestamp_cache.hpp>
+#include <functional>
+#include <iostream>
+
+using namespace core::logging;
+
+namespace
+{
+    // Calls fn for every record in the store, oldest first; returns the record count
+    size_t forEachEntry(const std::string &directory, const std::function<void(const CaptureEntry &)> &fn)
+    {
+        size_t records = 0;
+        CaptureEntry entry;
+        for (const std::string &segment : listCaptureSegments(directory))
+        {
+            CaptureSegmentReader reader(segment);
+            if (!reader.isValid())
+            {
+                std::cerr << "Skipping " << segment << ": not a capture segment\n";
+                continue;
+            }
+
+            while (reader.next(entry))
+            {
+                fn(entry);
+                ++records;
+            }
+
+            if (reader.truncated())
+            {
+                // Expected for the segment that was open when the game died
+                std::cerr << segment << ": truncated record at end of segment\n";
+            }
+        }
+        return records;
+    }
+
+    // Payload as indented text, whatever it was stored as
+    bool payloadText(const CaptureEntry &entry, std::string &out)
+    {
+        out.clear();
+        if (entry.payloadFormat == capture::PayloadFormat::AgBinary)
+        {
+            return hydra::ag_binary::to_text(entry.payload, out);
+        }
+        out = entry.payload;
+        return true;
+    }
+
+    int listSegments(const std::string &directory)
+    {
+        for (const std::string &segment : listCaptureSegments(directory))
+        {
+            CaptureSegmentReader reader(segment);
+            CaptureEntry entry;
+            size_t records = 0;
+            while (reader.next(entry))
+            {
+                ++records;
+            }
+
+            std::error_code ec;
+            std::cout << std::format("{}  {} bytes  {} records{}\n",
+                                     segment,
+                                     std::filesystem::file_size(segment, ec),
+                                     records,
+                                     !reader.isValid() ? "  (invalid)" : reader.truncated() ? "  (truncated)" : "");
+        }
+        return 0;
+    }
+
+    int dumpRecords(const std::string &directory)
+    {
+        TimestampCache timestamps("%Y-%m-%d %H:%M:%S", SubsecondPrecision::Milliseconds);
+        size_t records = forEachEntry(directory, [&](const CaptureEntry &entry) {
+            if (entry.direction == capture::Direction::Request)
+            {
+                std::cout << std::format("{} REQ  {} {}{} ({} bytes)\n",
+                                         timestamps.format(entry.time), entry.method, entry.host, entry.endpoint,
+                                         entry.payload.size());
+            }
+            else
+            {
+                std::cout << std::format("{} RESP {} {} ({} bytes)\n",
+                                         timestamps.format(entry.time), entry.responseCode, entry.endpoint,
+                                         entry.payload.size());
+            }
+        });
+        std::cerr << "Read " << records << " records\n";
+        return 0;
+    }
+
+    std::string jsonString(std::string_view text)
+    {
+        // Quotes, backslashes and control characters; everything else is passed through
+        std::string result = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                result.push_back('\\');
+                result.push_back(c);
+            }
+            else if (static_cast<uint8_t>(c) < 0x20)
+            {
+                result += std::format("\\u{:04x}", static_cast<uint8_t>(c));
+            }
+            else
+            {
+                result.push_back(c);
+            }
+        }
+        result.push_back('"');
+        return result;
+    }
+
+    int convert(const std::string &directory, bool json)
+    {
+        TimestampCache timestamps("%Y-%m-%dT%H:%M:%S", SubsecondPrecision::Milliseconds);
+        std::string payload;
+        size_t malformed = 0;
+        size_t records = forEachEntry(directory, [&](const CaptureEntry &entry) {
+            bool isRequest = entry.direction == capture::Direction::Request;
+            std::string_view time = timestamps.format(entry.time);
+
+            if (!json)
+            {
+                if (!payloadText(entry, payload))
+                {
+                    ++malformed;
+                }
+                std::cout << std::format("{} {} {}\n", time, isRequest ? "REQUEST" : "RESPONSE",
+                                         isRequest ? entry.method + " " + entry.host + entry.endpoint
+                                                   : std::to_string(entry.responseCode) + " " + entry.endpoint);
+                std::cout << (entry.payloadFormat == capture::PayloadFormat::None ? "No data\n" : payload) << "\n";
+                return;
+            }
+
+            payload.clear();
+            bool ok = true;
+            switch (entry.payloadFormat)
+            {
+            case capture::PayloadFormat::None:
+                payload = "null";
+                break;
+            case capture::PayloadFormat::AgBinary:
+                ok = hydra::ag_binary::to_json(entry.payload, payload);
+                break;
+            default:
+                // Text captures cannot be parsed back; keep the rendering as a string
+                payload = jsonString(entry.payload);
+                break;
+            }
+            if (!ok)
+            {
+                ++malformed;
+                payload = "null";
+            }
+
+            std::cout << std::format("{{\"time\":{},\"direction\":\"{}\",\"host\":{},\"endpoint\":{},"
+                                     "\"method\":{},\"code\":{},\"data\":{}}}\n",
+                                     jsonString(time), isRequest ? "request" : "response", jsonString(entry.host),
+                                     jsonString(entry.endpoint), jsonString(entry.method), entry.responseCode, payload);
+        });
+        std::cerr << "Converted " << records << " records";
+        if (malformed > 0)
+        {
+            std::cerr << ", " << malformed << " with malformed payloads";
+        }
+        std::cerr << "\n";
+        return malformed == 0 ? 0 : 1;
+    }
+
+    int query(const std::string &directory, std::string_view expression)
+    {
+        std::string error;
+        std::optional<hydra::PathQuery> path = hydra::PathQuery::compile(expression, &error);
+        if (!path)
+        {
+            std::cerr << "Invalid path: " << error << "\n";
+            return 1;
+        }
+
+        TimestampCache timestamps("%Y-%m-%d %H:%M:%S", SubsecondPrecision::Milliseconds);
+        hydra::ValueSnapshot snapshot;
+        std::vector<hydra::SnapshotValue> matches;
+        std::string rendered;
+        size_t found = 0;
+        size_t malformed = 0;
+        size_t records = forEachEntry(directory, [&](const CaptureEntry &entry) {
+            if (entry.payloadFormat != capture::PayloadFormat::AgBinary)
+            {
+                return;
+            }
+            if (!hydra::ag_binary::decode(entry.payload, snapshot))
+            {
+                ++malformed;
+                return;
+            }
+
+            matches.clear();
+            path->select(snapshot.root(), matches);
+            for (const hydra::SnapshotValue &match : matches)
+            {
+                rendered.clear();
+                hydra::JsonEmitter emitter(rendered);
+                hydra::visit(match, emitter);
+                std::cout << std::format("{} {} {} {}\n", timestamps.format(entry.time),
+                                         entry.direction == capture::Direction::Request ? "REQ " : "RESP",
+                                         entry.endpoint, rendered);
+            }
+            found += matches.size();
+        });
+        std::cerr << "Found " << found << " values in " << records << " records";
+        if (malformed > 0)
+        {
+            std::cerr << ", " << malformed << " with malformed payloads";
+        }
+        std::cerr << "\n";
+        return malformed == 0 ? 0 : 1;
+    }
+
+    int materialize(const std::string &directory, const std::string &output)
+    {
+        CaptureLayout layout(output);
+        CaptureEntry textEntry;
+        size_t failed = 0;
+        size_t records = forEachEntry(directory, [&](const CaptureEntry &entry) {
+            textEntry = entry;
+            if (entry.payloadFormat == capture::PayloadFormat::AgBinary)
+            {
+                textEntry.payloadFormat = capture::PayloadFormat::Text;
+                if (!payloadText(entry, textEntry.payload))
+                {
+                    std::cerr << "Malformed payload for " << entry.endpoint << "\n";
+                }
+            }
+            if (layout.write(textEntry).empty())
+            {
+                ++failed;
+            }
+        });
+        std::cerr << "Materialized " << records - failed << " of " << records << " records into " << output << "\n";
+        return failed == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string command = argc > 1 ? argv[1] : "";
+
+    if (command == "list" && argc == 3)
+    {
+        return listSegments(argv[2]);
+    }
+    if (command == "dump" && argc == 3)
+    {
+        return dumpRecords(argv[2]);
+    }
+    if (command == "materialize" && argc == 4)
+    {
+        // One line per written file is too noisy for a whole store
+        Logger::setMinLevel(LogLevel::Warning);
+        return materialize(argv[2], argv[3]);
+    }
+
+    if (command == "convert" && argc == 4 && (std::string(argv[3]) == "text" || std::string(argv[3]) == "json"))
+    {
+        return convert(argv[2], std::string(argv[3]) == "json");
+    }
+
+    if (command == "query" && argc == 4)
+    {
+        return query(argv[2], argv[3]);
+    }
+
+    std::cerr << "Usage:\n"
+              << "  " << argv[0] << " list <store_dir>\n"
+              << "  " << argv[0] << " dump <store_dir>\n"
+              << "  " << argv[0] << " materialize <store_dir> <output_dir>\n"
+              << "  " << argv[0] << " convert <store_dir> text|json\n"
+              << "  " << argv[0] << " query <store_dir> <path>\n";
+    return 1;
+}
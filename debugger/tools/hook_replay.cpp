@@ -0,0 +1,451 @@
+// Replays a capture store through the hooks' callbacks (hooks/callbacks.hpp),
+// with stubs in place of the game's functions, and measures what the hooks
+// add to each call.
+//
+// Usage:
+//   hook-replay <store_dir> [--threads N] [--passes N] [--output DIR]
+//               [--baseline FILE] [--write-baseline] [--threshold PERCENT]
+//
+// Every request and response record becomes a call to callback_make_request
+// or callback_request_response on a live hydra tree rebuilt with
+// hydra-synthetic. Only ag-binary payloads can be rebuilt; text captures
+// replay without data. Each of the N threads (default 1) acts as one client
+// and replays the whole store --passes times (default 1). Logs and captures
+// are written as the DLL writes them, minus the console, under --output (by
+// default a fresh temporary directory); the bytes that adds are reported
+// per call, along with the captures and log records dropped under load.
+//
+// The report goes to stderr, since stdout carries the callbacks' own console
+// output. It ends with the hooks' per-phase overhead (print, snapshot,
+// capture); the replay never adapts verbosity, so every call runs at full.
+//
+// --write-baseline saves the results to FILE. Otherwise, with --baseline,
+// the run fails if p50, p99 or disk bytes per call grow by more than
+// --threshold percent (default 10), or if calls per second drop by more than
+// that. The maximum is reported but not gated; a single preemption decides
+// it. How much is dropped depends on timing, and a dropped record is neither
+// written nor paid for, so when either run dropped captures or log records
+// the throughput and disk gates are skipped and the report says why.
+//
+// Exits with 0 when within the baseline, 1 on a regression and 2 on bad usage.
+
+#include <hooks/callbacks.hpp>
+#include <logging/capture_store.hpp>
+#include <logging/logger.hpp>
+#include <logging/sinks.hpp>
+#include <synthetic/builder.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace core::logging;
+
+namespace
+{
+    struct Options
+    {
+        std::string store;
+        unsigned threads = 1;
+        unsigned passes = 1;
+        std::string output;
+        std::string baseline;
+        bool writeBaseline = false;
+        double threshold = 10.0; // Percent
+    };
+
+    struct Call
+    {
+        capture::Direction direction;
+        std::string endpoint;
+        std::string method;
+        hydra::Value *data = nullptr;
+        hydra::Request *request = nullptr; // Responses only
+    };
+
+    struct Results
+    {
+        uint64_t p50 = 0; // Nanoseconds per call
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+        double callsPerSecond = 0.0;
+        double diskBytesPerCall = 0.0;
+        uint64_t droppedCaptures = 0; // Lossy runs skip the throughput and disk gates
+        uint64_t droppedLogRecords = 0;
+    };
+
+    void *stubRequestResponse(hydra::Client *, void *, hydra::Request **)
+    {
+        return nullptr;
+    }
+
+    void *stubMakeRequest(hydra::Client *, std::string &, std::string &, hydra::MapValue *, void *, void *, void *)
+    {
+        return nullptr;
+    }
+
+    // Builds every call up front, so the replay only runs the hooks
+    bool loadCalls(const std::string &directory, synthetic::Builder &builder, std::vector<Call> &out)
+    {
+        size_t withoutData = 0;
+        CaptureEntry entry;
+        for (const std::string &segment : listCaptureSegments(directory))
+        {
+            CaptureSegmentReader reader(segment);
+            if (!reader.isValid())
+            {
+                std::cerr << "Skipping " << segment << ": not a capture segment\n";
+                continue;
+            }
+
+            while (reader.next(entry))
+            {
+                Call call{entry.direction, entry.endpoint, entry.method};
+                if (entry.payloadFormat == capture::PayloadFormat::AgBinary)
+                {
+                    call.data = builder.from_capture(entry.payload);
+                }
+                if (!call.data && !entry.payload.empty())
+                {
+                    ++withoutData;
+                }
+
+                if (call.direction == capture::Direction::Response)
+                {
+                    call.request = builder.request(entry.endpoint, "application/x-ag-binary", entry.responseCode, call.data);
+                }
+                else if (call.data && call.data->type() != hydra::ValueType::Map)
+                {
+                    // The request hook only ever sees a map
+                    call.data = nullptr;
+                    ++withoutData;
+                }
+                out.push_back(std::move(call));
+            }
+        }
+
+        if (withoutData)
+        {
+            std::cerr << "Replaying " << withoutData << " captures without data (text or undecodable payloads)\n";
+        }
+        return !out.empty();
+    }
+
+    uint64_t directoryBytes(const std::filesystem::path &directory)
+    {
+        uint64_t total = 0;
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (it->is_regular_file(error))
+            {
+                total += it->file_size(error);
+            }
+        }
+        return total;
+    }
+
+    // Log and capture set up as MainThread does, minus the console
+    void startOutput(const std::filesystem::path &output)
+    {
+        RotationOptions rotation;
+        rotation.maxBytes = 64ull * 1024 * 1024;
+        rotation.maxFiles = 5;
+        getLogger().clearSinks();
+        getLogger().addSink(std::make_shared<RotatingFileSink>((output / "logs" / "debugger.log").string(), rotation));
+        getLogger().startAsync({16384, OverflowPolicy::DropOldest});
+
+        g_file_logger.enable_logging(true);
+        g_file_logger.set_base_directory((output / "request_logs").string());
+        g_file_logger.set_overhead_monitor(&g_overhead);
+        CaptureOptions captureOptions;
+        captureOptions.payload = CapturePayload::AgBinary;
+        captureOptions.compression = capture::Compression::Zlib;
+        g_file_logger.start(captureOptions);
+    }
+
+    void stopOutput()
+    {
+        g_file_logger.stop();
+        getLogger().stopAsync();
+        getLogger().flush();
+    }
+
+    Results replay(const Options &options, const std::vector<Call> &calls, synthetic::Builder &builder)
+    {
+        std::vector<hydra::Client *> clients;
+        for (unsigned i = 0; i < options.threads; ++i)
+        {
+            clients.push_back(builder.client(std::format("10.0.0.{}", i + 1)));
+        }
+
+        std::vector<LatencyHistogram> histograms(options.threads);
+        std::latch ready(options.threads + 1);
+        auto worker = [&](unsigned index) {
+            // The hooks take the strings by reference; each client has its own
+            std::vector<Call> own = calls;
+            hydra::Client *client = clients[index];
+            LatencyHistogram &histogram = histograms[index];
+            ready.arrive_and_wait();
+
+            for (unsigned pass = 0; pass < options.passes; ++pass)
+            {
+                for (Call &call : own)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    if (call.direction == capture::Direction::Request)
+                    {
+                        callback_make_request(client, call.endpoint, call.method, static_cast<hydra::MapValue *>(call.data), nullptr, nullptr, nullptr);
+                    }
+                    else
+                    {
+                        hydra::Request *request = call.request;
+                        callback_request_response(client, nullptr, &request);
+                    }
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 0; i < options.threads; ++i)
+        {
+            pool.emplace_back(worker, i);
+        }
+        ready.arrive_and_wait();
+        auto started = std::chrono::steady_clock::now();
+        for (std::thread &thread : pool)
+        {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        LatencyHistogram total;
+        for (const LatencyHistogram &histogram : histograms)
+        {
+            total.merge(histogram);
+        }
+
+        Results results;
+        results.p50 = total.percentile(0.50);
+        results.p99 = total.percentile(0.99);
+        results.max = total.max();
+        results.callsPerSecond = seconds > 0 ? static_cast<double>(total.count()) / seconds : 0.0;
+        return results;
+    }
+
+    bool readBaseline(const std::string &path, Results &out)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line);
+            std::string name;
+            double value;
+            if (!(fields >> name >> value))
+            {
+                continue;
+            }
+            if (name == "p50_ns")
+            {
+                out.p50 = static_cast<uint64_t>(value);
+            }
+            else if (name == "p99_ns")
+            {
+                out.p99 = static_cast<uint64_t>(value);
+            }
+            else if (name == "max_ns")
+            {
+                out.max = static_cast<uint64_t>(value);
+            }
+            else if (name == "calls_per_second")
+            {
+                out.callsPerSecond = value;
+            }
+            else if (name == "disk_bytes_per_call")
+            {
+                out.diskBytesPerCall = value;
+            }
+            else if (name == "dropped_captures")
+            {
+                out.droppedCaptures = static_cast<uint64_t>(value);
+            }
+            else if (name == "dropped_log_records")
+            {
+                out.droppedLogRecords = static_cast<uint64_t>(value);
+            }
+        }
+        return true;
+    }
+
+    bool writeBaseline(const std::string &path, const Results &results)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "p50_ns " << results.p50 << "\n"
+             << "p99_ns " << results.p99 << "\n"
+             << "max_ns " << results.max << "\n"
+             << std::format("calls_per_second {:.1f}\n", results.callsPerSecond)
+             << std::format("disk_bytes_per_call {:.1f}\n", results.diskBytesPerCall)
+             << "dropped_captures " << results.droppedCaptures << "\n"
+             << "dropped_log_records " << results.droppedLogRecords << "\n";
+        return static_cast<bool>(file);
+    }
+
+    // Prints one metric against the baseline; true if it regressed past the threshold
+    bool compare(std::string_view name, double current, double baseline, bool higherIsWorse, double threshold)
+    {
+        double change = baseline > 0 ? (current - baseline) / baseline * 100.0 : 0.0;
+        bool regressed = higherIsWorse ? change > threshold : -change > threshold;
+        std::cerr << std::format("  {:<20} {:>14.1f} (baseline {:.1f}, {:+.1f}%){}\n", name, current, baseline, change,
+                                 regressed ? "  REGRESSED" : "");
+        return regressed;
+    }
+
+    int run(const Options &options)
+    {
+        synthetic::Builder builder;
+        std::vector<Call> calls;
+        if (!loadCalls(options.store, builder, calls))
+        {
+            std::cerr << "No captures in " << options.store << "\n";
+            return 2;
+        }
+
+        std::filesystem::path output = options.output;
+        if (output.empty())
+        {
+            output = std::filesystem::temp_directory_path() / "hook-replay";
+            std::filesystem::remove_all(output);
+        }
+        std::filesystem::create_directories(output);
+        uint64_t bytesBefore = directoryBytes(output);
+
+        original_make_request_fn = reinterpret_cast<void *>(&stubMakeRequest);
+        original_request_response_fn = reinterpret_cast<void *>(&stubRequestResponse);
+
+        startOutput(output);
+        uint64_t logDroppedBefore = getLogger().droppedRecords();
+        Results results = replay(options, calls, builder);
+        stopOutput();
+        results.droppedCaptures = g_file_logger.stats().dropped;
+        results.droppedLogRecords = getLogger().droppedRecords() - logDroppedBefore;
+
+        uint64_t totalCalls = static_cast<uint64_t>(calls.size()) * options.threads * options.passes;
+        results.diskBytesPerCall = static_cast<double>(directoryBytes(output) - bytesBefore) / static_cast<double>(totalCalls);
+
+        std::cerr << std::format("Replayed {} calls on {} thread(s)\n", totalCalls, options.threads)
+                  << std::format("  p50 {}ns  p99 {}ns  max {}ns\n", results.p50, results.p99, results.max)
+                  << std::format("  {:.0f} calls/s, {:.1f} disk bytes/call\n", results.callsPerSecond, results.diskBytesPerCall)
+                  << std::format("  {} captures and {} log records dropped\n", results.droppedCaptures, results.droppedLogRecords);
+        g_overhead.collect();
+        std::cerr << g_overhead.report();
+
+        if (options.writeBaseline)
+        {
+            if (!writeBaseline(options.baseline, results))
+            {
+                std::cerr << "Cannot write " << options.baseline << "\n";
+                return 2;
+            }
+            std::cerr << "Baseline written to " << options.baseline << "\n";
+            return 0;
+        }
+        if (options.baseline.empty())
+        {
+            return 0;
+        }
+
+        Results baseline;
+        if (!readBaseline(options.baseline, baseline))
+        {
+            std::cerr << "Cannot read " << options.baseline << "\n";
+            return 2;
+        }
+
+        std::cerr << std::format("Against {} (threshold {:.1f}%):\n", options.baseline, options.threshold);
+        bool regressed = false;
+        regressed |= compare("p50_ns", static_cast<double>(results.p50), static_cast<double>(baseline.p50), true, options.threshold);
+        regressed |= compare("p99_ns", static_cast<double>(results.p99), static_cast<double>(baseline.p99), true, options.threshold);
+        if (results.droppedCaptures + results.droppedLogRecords + baseline.droppedCaptures + baseline.droppedLogRecords > 0)
+        {
+            std::cerr << std::format("  calls_per_second and disk_bytes_per_call not gated: this run dropped {} captures "
+                                     "and {} log records, the baseline {} and {}\n",
+                                     results.droppedCaptures, results.droppedLogRecords, baseline.droppedCaptures,
+                                     baseline.droppedLogRecords);
+            return regressed ? 1 : 0;
+        }
+        regressed |= compare("calls_per_second", results.callsPerSecond, baseline.callsPerSecond, false, options.threshold);
+        regressed |= compare("disk_bytes_per_call", results.diskBytesPerCall, baseline.diskBytesPerCall, true, options.threshold);
+        return regressed ? 1 : 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    std::vector<std::string> positional;
+    bool valid = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--passes" && i + 1 < argc)
+        {
+            options.passes = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--baseline" && i + 1 < argc)
+        {
+            options.baseline = argv[++i];
+        }
+        else if (arg == "--write-baseline")
+        {
+            options.writeBaseline = true;
+        }
+        else if (arg == "--threshold" && i + 1 < argc)
+        {
+            options.threshold = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg.starts_with("--"))
+        {
+            valid = false;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+
+    if (!valid || positional.size() != 1 || options.threads == 0 || options.passes == 0 ||
+        (options.writeBaseline && options.baseline.empty()))
+    {
+        std::cerr << "Usage:\n"
+                  << "  " << argv[0] << " <store_dir> [--threads N] [--passes N] [--output DIR]\n"
+                  << "      [--baseline FILE] [--write-baseline] [--threshold PERCENT]\n";
+        return 2;
+    }
+
+    options.store = positional[0];
+    return run(options);
+}
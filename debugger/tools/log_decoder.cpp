@@ -0,0 +1,174 @@
+// Turns a .binlog written by BinaryLogger back into the text log format:
+//   [file:line] HH:MM:SS [LEVEL] message
+//
+// Usage: log-decoder <input.binlog> [output.txt]
+
+#include <logging/binary_log.hpp>
+#include <logging/timestamp_cache.hpp>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+
+using namespace core::logging;
+
+namespace
+{
+    struct SiteInfo
+    {
+        LogLevel level;
+        uint32_t line;
+        std::string file;
+        std::string format;
+    };
+
+    class Reader
+    {
+    public:
+        explicit Reader(const std::vector<uint8_t> &data) : m_data(data) {}
+
+        template <typename T>
+        bool read(T &out)
+        {
+            if (m_data.size() - m_pos < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&out, m_data.data() + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+            return true;
+        }
+
+        bool readString(std::string &out)
+        {
+            uint16_t length;
+            if (!read(length) || m_data.size() - m_pos < length)
+            {
+                return false;
+            }
+            out.assign(reinterpret_cast<const char *>(m_data.data() + m_pos), length);
+            m_pos += length;
+            return true;
+        }
+
+        const uint8_t *take(size_t size)
+        {
+            if (m_data.size() - m_pos < size)
+            {
+                return nullptr;
+            }
+            const uint8_t *data = m_data.data() + m_pos;
+            m_pos += size;
+            return data;
+        }
+
+        bool done() const
+        {
+            return m_pos >= m_data.size();
+        }
+
+    private:
+        const std::vector<uint8_t> &m_data;
+        size_t m_pos = 0;
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.binlog> [output.txt]\n";
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Failed to open " << argv[1] << "\n";
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    std::ofstream file;
+    if (argc > 2)
+    {
+        file.open(argv[2]);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    std::ostream &out = argc > 2 ? file : std::cout;
+
+    Reader reader(data);
+    char magic[sizeof(binary::FileMagic)];
+    uint32_t version;
+    if (!reader.read(magic) || std::memcmp(magic, binary::FileMagic, sizeof(magic)) != 0 ||
+        !reader.read(version) || version != binary::FileVersion)
+    {
+        std::cerr << "Not a binary log (or unsupported version)\n";
+        return 1;
+    }
+
+    std::unordered_map<uint32_t, SiteInfo> sites;
+    TimestampCache timestamps;
+    size_t records = 0;
+
+    while (!reader.done())
+    {
+        uint8_t tag;
+        reader.read(tag);
+
+        if (tag == static_cast<uint8_t>(binary::EntryTag::Site))
+        {
+            uint32_t id;
+            uint8_t level;
+            SiteInfo site;
+            if (!reader.read(id) || !reader.read(level) || !reader.read(site.line) ||
+                !reader.readString(site.file) || !reader.readString(site.format))
+            {
+                std::cerr << "Truncated site entry\n";
+                return 1;
+            }
+            site.level = static_cast<LogLevel>(level);
+            sites[id] = std::move(site);
+            continue;
+        }
+
+        if (tag != static_cast<uint8_t>(binary::EntryTag::Record))
+        {
+            std::cerr << "Unknown entry tag 0x" << std::hex << static_cast<int>(tag) << "\n";
+            return 1;
+        }
+
+        binary::RecordHeader header;
+        const uint8_t *payload = nullptr;
+        if (!reader.read(header) || !(payload = reader.take(header.payloadSize)))
+        {
+            // A log cut off mid-write: keep what was decoded so far
+            std::cerr << "Truncated record, stopping\n";
+            break;
+        }
+
+        auto site = sites.find(header.siteId);
+        if (site == sites.end())
+        {
+            std::cerr << "Record references unknown site " << header.siteId << "\n";
+            continue;
+        }
+
+        out << std::format("[{}:{}] {} [{}] {}\n",
+                           getFileName(site->second.file),
+                           site->second.line,
+                           timestamps.format(std::chrono::system_clock::time_point(
+                               std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                   std::chrono::nanoseconds(header.timestampNs)))),
+                           getLevelString(site->second.level),
+                           binary::formatMessage(site->second.format, payload, header.payloadSize));
+        ++records;
+    }
+
+    std::cerr << "Decoded " << records << " records\n";
+    return 0;
+}